@@ -0,0 +1,135 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include <boost/graph/adjacency_list.hpp>
+
+#include "stream-dfs.h"
+#include "ready-queue.h"
+
+// Simulates xmltsort running a big hierarchy with a fixed number of
+// processes and compares the makespan when ready vertices run in the order
+// they became ready and when the critical path goes first.
+//
+// The hierarchy is the one in data/small.xml repeated.  Each copy's 'h'
+// also depends on the next copy's 'a', which makes one long chain through
+// all of them with plenty of other work on the side.  The costs are made up
+// but the same every time.
+//
+// It exits with 1 if some vertex never runs.
+
+typedef boost::adjacency_list<
+    boost::vecS,
+    boost::vecS,
+    boost::bidirectionalS
+  > bench_base;
+
+typedef boost::StreamDfs< bench_base >     bench_graph;
+typedef boost::graph_traits< bench_graph > g_traits;
+
+// a b c d e f g h i j k
+enum { A, B, C, D, E, F, G, H, I, J, K, BLOCKS };
+
+static const int hierarchy[][2] = {
+  { A, B }, { A, C }, { A, D }, { A, E },
+  { B, C },
+  { E, F }, { E, G }, { E, H },
+  { F, G },
+  { G, I }, { G, J }, { G, K }
+};
+
+// Adds every vertex and makes up its cost.  The edges are kept aside so
+// they can be added as each vertex is found, like xmltsort does.
+static void build( bench_graph &g,
+                   std::vector<double> &cost,
+                   std::vector< std::vector<int> > &depends,
+                   int copies ) {
+  unsigned int seed = 12345;
+  for( int v = 0; v < copies * BLOCKS; ++v ) {
+    boost::add_vertex( g );
+    seed = seed * 1103515245 + 12345;
+    cost.push_back( 1 + ( seed >> 16 ) % 20 );
+  }
+
+  depends.resize( copies * BLOCKS );
+  for( int copy = 0; copy < copies; ++copy ) {
+    int base = copy * BLOCKS;
+    for( size_t e = 0; e < sizeof( hierarchy ) / sizeof( hierarchy[0] ); ++e )
+      depends[ base + hierarchy[e][0] ].push_back( base + hierarchy[e][1] );
+    if( copy + 1 < copies )
+      depends[ base + H ].push_back( base + BLOCKS + A );
+  }
+}
+
+// Returns the time the last vertex finishes or -1 if some never ran.
+static double simulate( int copies, int procs, bool critical_path ) {
+  bench_graph g;
+  std::vector<double> cost;
+  std::vector< std::vector<int> > depends;
+  build( g, cost, depends, copies );
+
+  ready_queue<bench_graph> ready( g );
+  ready.set_critical_path( critical_path );
+
+  // Found top down the way they come in the input
+  for( size_t v = 0; v < cost.size(); ++v ) {
+    for( size_t t = 0; t < depends[ v ].size(); ++t )
+      boost::add_edge( v, depends[ v ][ t ], g );
+    ready.found( v, cost[ v ] );
+    g.found_vertex( v );
+  }
+
+  typedef std::pair<double, g_traits::vertex_descriptor> event;
+  std::priority_queue<event, std::vector<event>, std::greater<event> > running;
+  double now = 0;
+  size_t done = 0;
+  while( true ) {
+    g_traits::vertex_descriptor v;
+    while( running.size() < static_cast<size_t>( procs ) and ready.next( v ) )
+      running.push( event( now + cost[ v ], v ) );
+
+    if( running.empty() )
+      break;
+    now = running.top().first;
+    g.mark_connected( running.top().second );
+    running.pop();
+    ++done;
+  }
+
+  return done == cost.size() ? now : -1;
+}
+
+int main( int argc, char *argv[] ) {
+  int copies = 10000;
+  int procs  = 8;
+  if( 1 < argc )
+    copies = atoi( argv[1] );
+  if( 2 < argc )
+    procs = atoi( argv[2] );
+  if( copies < 1 or procs < 1 ) {
+    std::cerr << "Usage: " << argv[0] << " [copies] [procs]" << std::endl;
+    exit(1);
+  }
+
+  double fifo     = simulate( copies, procs, false );
+  double critical = simulate( copies, procs, true );
+
+  std::cout << copies * BLOCKS << " vertices on " << procs << " processes:"
+            << " fifo " << fifo
+            << " critical-path " << critical
+            << std::endl;
+
+  if( fifo < 0 or critical < 0 ) {
+    std::cerr << "Some vertices never ran" << std::endl;
+    exit(1);
+  }
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#include <time.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <boost/graph/adjacency_list.hpp>
+
+#include "stream-dfs.h"
+
+// Times StreamDfs on a few made up graphs that are much bigger than the
+// stack.  Each graph is built three times so that every run starts from
+// scratch:
+//
+//  * schedule: found_vertex() on every vertex in order and then run the ready
+//    vertices one at a time the way xmltsort does.
+//  * fail:     a vertex at the bottom fails and takes its dependents with it.
+//  * iterate:  walk the streaming vertex iterator.
+//  * cycles:   one more edge closes a cycle through the bottom vertex and
+//    find_cycles() looks for it.
+//
+// It exits with 1 if any of them doesn't touch every vertex it should.
+
+typedef boost::adjacency_list<
+    boost::vecS,
+    boost::vecS,
+    boost::bidirectionalS
+  > bench_base;
+
+typedef boost::StreamDfs< bench_base >  bench_graph;
+typedef boost::graph_traits< bench_graph > g_traits;
+
+enum shape { CHAIN, FAN_IN, FAN_OUT };
+
+static const char *shape_names[] = { "chain", "fan-in", "fan-out" };
+
+// An edge points from a vertex to one it depends on.
+//
+//  * chain:   each vertex depends on the next one.
+//  * fan-in:  every vertex depends on the first one.
+//  * fan-out: the first vertex depends on all of the others.
+static void build( bench_graph &g, shape s, std::size_t n ) {
+  for( std::size_t v = 0; v < n; ++v )
+    boost::add_vertex( g );
+
+  for( std::size_t v = 1; v < n; ++v )
+    switch( s ) {
+      case CHAIN:   boost::add_edge( v - 1, v, g ); break;
+      case FAN_IN:  boost::add_edge( v, 0, g );     break;
+      case FAN_OUT: boost::add_edge( 0, v, g );     break;
+    }
+}
+
+// The vertex to fail.  In a fan-out only the first vertex depends on it.
+static std::size_t bottom( shape s, std::size_t n ) {
+  return FAN_IN == s ? 0 : n - 1;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static std::size_t schedule( bench_graph &g, std::size_t n ) {
+  std::size_t run = 0;
+  for( std::size_t v = 0; v < n; ++v )
+    g.found_vertex( v );
+
+  while( not g.ready.empty() ) {
+    g_traits::vertex_descriptor v = g.ready.front();
+    g.ready.pop();
+    g.mark_connected( v );
+    ++run;
+  }
+  return run;
+}
+
+static std::size_t fail( bench_graph &g, shape s, std::size_t n ) {
+  for( std::size_t v = 0; v < n; ++v )
+    g.found_vertex( v );
+
+  g.mark_failed( bottom( s, n ) );
+  return g.newly_failed.size();
+}
+
+static std::size_t cycles( bench_graph &g, shape s, std::size_t n ) {
+  // Back from the bottom to where the edges start
+  if( FAN_IN == s )
+    boost::add_edge( 0, n - 1, g );
+  else
+    boost::add_edge( bottom( s, n ), 0, g );
+
+  for( std::size_t v = 0; v < n; ++v )
+    g.found_vertex( v );
+
+  std::vector< std::vector<g_traits::vertex_descriptor> > found;
+  g.find_cycles( found );
+
+  std::size_t members = 0;
+  for( std::size_t i = 0; i < found.size(); ++i )
+    members += found[ i ].size();
+  return members;
+}
+
+static std::size_t iterate( bench_graph &g ) {
+  std::size_t count = 0;
+  g_traits::vertex_iterator i, end;
+  for( boost::tie( i, end ) = vertices( g ); i != end; ++i )
+    ++count;
+  return count;
+}
+
+int main( int argc, char *argv[] ) {
+  std::size_t n = 1000000;
+  if( 1 < argc )
+    n = strtoul( argv[1], NULL, 10 );
+  if( n < 2 ) {
+    std::cerr << "Usage: " << argv[0] << " [vertices]" << std::endl;
+    exit(1);
+  }
+
+  bool ok = true;
+  for( int s = CHAIN; s <= FAN_OUT; ++s ) {
+    double times[4];
+    std::size_t counts[4];
+
+    for( int run = 0; run < 4; ++run ) {
+      bench_graph g;
+      build( g, shape( s ), n );
+
+      double start = now();
+      switch( run ) {
+        case 0: counts[ run ] = schedule( g, n );             break;
+        case 1: counts[ run ] = fail( g, shape( s ), n );     break;
+        case 2: counts[ run ] = iterate( g );                 break;
+        case 3: counts[ run ] = cycles( g, shape( s ), n );   break;
+      }
+      times[ run ] = now() - start;
+    }
+
+    std::size_t failed = FAN_OUT == s ? 2 : n;
+    std::size_t cycle  = CHAIN == s ? n : 2;
+    ok = ok and n == counts[0] and failed == counts[1] and n == counts[2] and cycle == counts[3];
+
+    std::cout << shape_names[ s ] << " " << n << " vertices:"
+              << " schedule " << times[0] << "s"
+              << " fail "     << times[1] << "s"
+              << " iterate "  << times[2] << "s"
+              << " cycles "   << times[3] << "s"
+              << std::endl;
+  }
+
+  if( not ok ) {
+    std::cerr << "Some vertices were missed" << std::endl;
+    exit(1);
+  }
+  return 0;
+}
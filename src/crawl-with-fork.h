@@ -7,8 +7,27 @@
 #ifndef CRAWL_WITH_FORK_H
 #define CRAWL_WITH_FORK_H
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
 #include "xpath-on-stream.h"
 #include "process-handler.h"
+#include "output-sink.h"
+#include "split-writer.h"
+#include "run-journal.h"
 
 template<class Ch, class Tr = std::char_traits<Ch> >
 class basic_marcher : public basic_xpath_stream<Ch, Tr>, public process_handler {
@@ -18,14 +37,88 @@ class basic_marcher : public basic_xpath_stream<Ch, Tr>, public process_handler
     basic_marcher( std::istream &in, const char *expression, const char **argv, bool allatonce )
       : parent( in, expression, allatonce ),
         process_handler( argv ),
-        printroot( false )
+        printroot( false ),
+        persistent( false ),
+        builtin( find_builtin( get_argv() ) ),
+        shards( 0 ),
+        num_split( 0 ),
+        keyctx( NULL ),
+        keycomp( NULL ),
+        open_files( open_file_limit() ),
+        output_error_reported( false )
     {}
 
 
-    virtual ~basic_marcher() {}
+    virtual ~basic_marcher() {
+      if( keycomp )
+        xmlXPathFreeCompExpr( keycomp );
+      if( keyctx )
+        xmlXPathFreeContext( keyctx );
+    }
 
     void set_printroot( bool enabled ) { printroot = enabled; }
 
+    /*
+     * In persistent mode the command is started once per -P slot and each
+     * element is written to an idle worker's standard input followed by a
+     * NUL byte.  The worker writes the decimal exit status of each record,
+     * followed by a newline, to file descriptor 3.
+     */
+    void set_persistent( bool enabled ) { persistent = enabled; }
+
+    /*
+     * A few trivial commands are run in this process instead of starting a
+     * child for each element.  They write exactly what the real command
+     * would and give the same exit status:
+     *
+     *   cat             the element as the child would read it on stdin
+     *   true, false     nothing, exit status 0 or 1
+     *   printenv VAR..  the value each variable would have in the child
+     *
+     * This turns that off so that the command found in PATH is always run.
+     */
+    void set_builtins( bool enabled ) {
+      if( not enabled )
+        builtin = BUILTIN_NONE;
+    }
+
+    /*
+     * Instead of running a command write each element, followed by a
+     * newline, to the file named by expanding the template.  $name or
+     * ${name} is replaced by the value that variable would have in the
+     * environment of the command (see set_environment()).  Any '/' in a
+     * value is replaced by '_' so that values can't name other directories.
+     * A variable that isn't set or is empty, '.' or '..' is an error.
+     *
+     * With shards the variable XMLSHARD is also set.  It counts from 0 to
+     * shards - 1 and goes round for each element.
+     */
+    void set_split( const std::string &name_template, int num_shards = 0 ) {
+      split_template = name_template;
+      shards         = num_shards;
+    }
+
+    /*
+     * Writes each job that is run to the journal and skips elements that it
+     * says already succeeded.  An element's key is the string value of the
+     * expression evaluated at the element or, without one, a hash of its
+     * text.  Elements with the same text are told apart by counting them in
+     * the order they are found: the second one's key ends in ".2" and so on.
+     * Only jobs that run a command or a built-in are journaled.
+     */
+    void set_journal( run_journal *journal, const char *keyexpr = NULL ) {
+      process_handler::set_journal( journal );
+      if( not keyexpr )
+        return;
+
+      keycomp = xmlXPathCompile( toXmlChar( keyexpr ) );
+      if( not keycomp ) {
+        std::cerr << "Invalid XPath expression '" << keyexpr << "'" << std::endl;
+        exit(1);
+      }
+      keyctx = xmlXPathNewContext( NULL );
+    }
+
   protected:
     void end_xml() {
       if( printroot ) std::cout << "</" << basic_xpath_stream<Ch, Tr>::rootname << ">" << std::flush;
@@ -36,13 +129,92 @@ class basic_marcher : public basic_xpath_stream<Ch, Tr>, public process_handler
     }
 
     void handle_node( xmlNodePtr node ) {
-      handle_node_fork( node );
+      std::string key;
+      if( journal() ) {
+        key = node_key( node );
+        if( journal()->succeeded( key ) )
+          return;
+      }
+
+      if( not split_template.empty() )
+        handle_node_split( node );
+      else if( persistent )
+        handle_node_persistent( node );
+      else if( builtin )
+        handle_node_builtin( node, key );
+      else
+        handle_node_queued( node, key );
+    }
+
+    std::string node_key( xmlNodePtr node ) {
+      if( not keycomp ) {
+        const char *data = toChar( serialize_node( node ) );
+        std::string key = run_journal::content_key( data, strlen( data ) );
+
+        bool   added;
+        size_t index;
+        size_t &copies = content_keys.intern( key.data(), key.size(), added, index );
+        if( 1 < ++copies ) {
+          char copy[ 24 ];
+          snprintf( copy, sizeof( copy ), ".%lu", static_cast<unsigned long>( copies ) );
+          key += copy;
+        }
+        return key;
+      }
+
+      keyctx->doc  = node->doc;
+      keyctx->node = node;
+      std::string key;
+      xmlXPathObjectPtr obj = xmlXPathCompiledEval( keycomp, keyctx );
+      if( obj ) {
+        xmlChar *value = xmlXPathCastToString( obj );
+        key = toChar( value );
+        xmlFree( value );
+        xmlXPathFreeObject( obj );
+      }
+      return key;
+    }
+
+    void chunk_handled() {
+      start_ready( max_ready() );
+    }
+
+    /*
+     * While jobs are queued waiting for a slot, wait for the input and for
+     * the children at the same time so that the next job starts as soon as
+     * any child exits even when the input is slow to arrive.
+     */
+    void wait_for_input() {
+      while( not ready.empty() ) {
+        bool readable = process_handler::wait_for_child_or_input( parent::input_fd() );
+        start_ready( max_ready() );
+        if( readable )
+          return;
+      }
+    }
+
+    void chunk_size_changed( int size ) {
+      if( verbose() )
+        std::cerr << "chunk size " << size << " bytes" << std::endl;
     }
 
     void finish() {
+      if( persistent )
+        stop_workers();
+      start_ready( 0 );
       process_handler::reap_all_active();
+      out.flush();
+      if( output_failed() )
+        handle_exit_status( 1 );
+      splitter.close_all();
+      if( splitter.failed() )
+        exit(1);
+      if( journal() )
+        journal()->sync();
     }
 
+    typedef std::vector< std::pair<std::string,std::string> > env_list;
+
     /*
      * Sets XMLELEMENT equal to the name of the element passed as the node.
      *
@@ -63,51 +235,106 @@ class basic_marcher : public basic_xpath_stream<Ch, Tr>, public process_handler
      *   export name='myname'
      */
     int set_environment( xmlNodePtr node ) {
-      int rc = setenv( "XMLELEMENT", toChar( node->name ), true );
+      env_list env;
+      node_environment( node, env );
 
-      if( rc ) {
-        std::cerr << "Couldn't set environment" << std::endl;
-        abort();
-      }
+      for( env_list::const_iterator i = env.begin(); i != env.end(); ++i )
+        if( setenv( i->first.c_str(), i->second.c_str(), true ) ) {
+          std::cerr << "Couldn't set environment" << std::endl;
+          abort();
+        }
+
+      return 0;
+    }
+
+    /*
+     * Same as set_environment() but the variables go into an environment
+     * prepared in the parent for spawn_program().
+     */
+    void set_environment( xmlNodePtr node, spawn_environment &spawn_env ) {
+      env_list env;
+      node_environment( node, env );
+
+      for( env_list::const_iterator i = env.begin(); i != env.end(); ++i )
+        if( not spawn_env.set( i->first, i->second ) ) {
+          std::cerr << "Couldn't set environment" << std::endl;
+          abort();
+        }
+    }
+
+    /*
+     * Lists the variables described above in the order they are set.  Later
+     * entries override earlier ones with the same name.
+     */
+    void node_environment( xmlNodePtr node, env_list &env ) {
+      env.push_back( std::make_pair( std::string( "XMLELEMENT" ),
+                                     std::string( toChar( node->name ) ) ) );
 
       bool settext = false;
       for( xmlNodePtr child = node->children; child; child = child->next ) {
-        if( not child->children ) {
-          rc = setenv( toChar( child->name ), "", true );
-          if( rc ) {
-            std::cerr << "Couldn't set environment" << std::endl;
-            abort();
-          }
-        }
+        if( not child->children )
+          env.push_back( std::make_pair( std::string( toChar( child->name ) ),
+                                         std::string() ) );
         if( child->children &&
             not child->children->next &&
-            XML_TEXT_NODE == child->children->type ) {
-          rc = setenv( toChar( child->name ),
-                       toChar( serialize_node( child->children ) ),
-                       true );
-          if( rc ) {
-            std::cerr << "Couldn't set environment" << std::endl;
-            abort();
-          }
-        }
+            XML_TEXT_NODE == child->children->type )
+          env.push_back( std::make_pair( std::string( toChar( child->name ) ),
+                                         std::string( toChar( serialize_node( child->children ) ) ) ) );
         if( not settext and XML_TEXT_NODE == child->type ) {
           settext = true;
-          rc = setenv( "XMLTEXT", toChar( serialize_node( child ) ), true );
+          env.push_back( std::make_pair( std::string( "XMLTEXT" ),
+                                         std::string( toChar( serialize_node( child ) ) ) ) );
+        }
+      }
+    }
 
-          if( rc ) {
-            std::cerr << "Couldn't set environment" << std::endl;
-            abort();
-          }
+    /*
+     * Serializes the node and returns a file descriptor from which the
+     * worker can read it as its stdin.  Small elements are written straight
+     * into a pipe which can hold all of it without blocking.  Bigger ones go
+     * into a sealed memfd.  Either way no helper process is needed.
+     *
+     * Returns -1 if neither is possible and spawn_input_source() has to be
+     * used instead.
+     */
+    int node_input( xmlNodePtr node ) {
+      xmlBufferPtr buf = xmlBufferCreate();
+      xmlNodeDump( buf, node->doc, node, 0, 0 );
+      const xmlChar *data = xmlBufferContent( buf );
+      int            len  = xmlBufferLength( buf );
+      int            fd   = -1;
+
+#ifdef F_GETPIPE_SZ
+      int p[2];
+      if( 0 == pipe2( p, O_CLOEXEC ) ) {
+        if( len <= fcntl( p[1], F_GETPIPE_SZ ) ) {
+          write_all( p[1], data, len );
+          fd = p[0];
+        } else {
+          close( p[0] );
         }
+        close( p[1] );
+      }
+#endif
 
+#ifdef MFD_ALLOW_SEALING
+      if( -1 == fd ) {
+        fd = memfd_create( "xmlelement", MFD_CLOEXEC | MFD_ALLOW_SEALING );
+        if( -1 != fd ) {
+          write_all( fd, data, len );
+          lseek( fd, 0, SEEK_SET );
+          fcntl( fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL );
+        }
       }
+#endif
 
-      return 0;
+      xmlBufferFree( buf );
+      return fd;
     }
 
     /*
      * Spawns a child process who will provide the worker process with the XML
-     * data on stdin.
+     * data on stdin.  This is only used when node_input() can't be.
      *
      * Returns only if we're in the parent process.  Otherwise exits.
      */
@@ -149,7 +376,87 @@ class basic_marcher : public basic_xpath_stream<Ch, Tr>, public process_handler
       close( fd[WRITE] );
     }
 
+    /*
+     * Jobs that are ready to start but are waiting for a free slot.  The
+     * element has already been serialized so the tree can be freed.  While
+     * all slots are busy parsing carries on and matches queue up here, up to
+     * max_ready() of them.  Only then does the parser wait for a child.
+     *
+     * Each one holds its input open so there can't be more of them than the
+     * open file limit allows next to the pidfds of the running children.
+     */
+    struct ready_job {
+      int               input;
+      spawn_environment env;
+      std::string       key;
+    };
+
+    size_t max_ready() {
+      // Leave some room for stdio, the input, the journal and the like.
+      size_t procs = process_handler::max_procs();
+      size_t used  = procs + 32;
+      return std::min( 4 * procs, open_files > used ? open_files - used : 0 );
+    }
+
+    static size_t open_file_limit() {
+      struct rlimit rl;
+      if( 0 == getrlimit( RLIMIT_NOFILE, &rl ) and RLIM_INFINITY != rl.rlim_cur )
+        return rl.rlim_cur;
+      return static_cast<size_t>( -1 );
+    }
+
+    void handle_node_queued( xmlNodePtr node, const std::string &key ) {
+      int input = node_input( node );
+      if( -1 == input ) {
+        // Keep things in order if the old fashioned way is needed.
+        start_ready( 0 );
+        journal_job( handle_node_fork( node ), key );
+        return;
+      }
+
+      ready.push_back( ready_job() );
+      ready.back().input = input;
+      ready.back().key   = key;
+      set_environment( node, ready.back().env );
+
+      start_ready( max_ready() );
+    }
+
+    /*
+     * Starts queued jobs in order as slots become free.  Only waits for a
+     * child to exit while more than 'keep' jobs are still queued.
+     */
+    void start_ready( size_t keep ) {
+      if( not ready.empty() )
+        process_handler::reap_finished();
+
+      while( not ready.empty() ) {
+        if( not process_handler::slot_available() ) {
+          if( ready.size() <= keep )
+            return;
+          process_handler::reap_process();
+        }
+
+        ready_job &job = ready.front();
+        journal_job( spawn_program( get_argv(), job.input, -1, &job.env ), job.key );
+        close( job.input );
+        ready.pop_front();
+      }
+    }
+
     pid_t handle_node_fork( xmlNodePtr node ) {
+      int input = node_input( node );
+
+      if( -1 != input ) {
+        // Everything the child needs is prepared here so it can be started
+        // without copying this process.
+        spawn_environment env;
+        set_environment( node, env );
+        pid_t pid = spawn_program( get_argv(), input, -1, &env );
+        close( input );
+        return pid;
+      }
+
       if( pid_t pid = spawn_worker() )
         return pid;
 
@@ -158,9 +465,363 @@ class basic_marcher : public basic_xpath_stream<Ch, Tr>, public process_handler
       exec_program();
     }
 
+    /*
+     * Built-in commands
+     */
+    enum builtin_command {
+      BUILTIN_NONE = 0,
+      BUILTIN_CAT,
+      BUILTIN_TRUE,
+      BUILTIN_FALSE,
+      BUILTIN_PRINTENV
+    };
+
+    static builtin_command find_builtin( const char **argv ) {
+      if( not strcmp( "printenv", argv[0] ) and argv[1] ) {
+        // Only plain variable names, no options.
+        for( const char **arg = argv + 1; *arg; ++arg )
+          if( '-' == **arg )
+            return BUILTIN_NONE;
+        return BUILTIN_PRINTENV;
+      }
+
+      if( argv[1] )
+        return BUILTIN_NONE;
+      if( not strcmp( "cat", argv[0] ) )
+        return BUILTIN_CAT;
+      if( not strcmp( "true", argv[0] ) )
+        return BUILTIN_TRUE;
+      if( not strcmp( "false", argv[0] ) )
+        return BUILTIN_FALSE;
+      return BUILTIN_NONE;
+    }
+
+    void handle_node_builtin( xmlNodePtr node, const std::string &key ) {
+      if( verbose() )
+        print_command( get_argv() );
+      double started = journal() ? run_journal::now() : 0;
+
+      int status = 0;
+      switch( builtin ) {
+        case BUILTIN_CAT : {
+          const char *data = toChar( serialize_node( node ) );
+          out.write( data, strlen( data ) );
+          break;
+        }
+
+        case BUILTIN_FALSE :
+          status = 1;
+          break;
+
+        case BUILTIN_PRINTENV : {
+          env_list env;
+          node_environment( node, env );
+          for( const char **name = get_argv() + 1; *name; ++name ) {
+            const char *value = NULL;
+            for( env_list::const_reverse_iterator i = env.rbegin(); i != env.rend(); ++i )
+              if( i->first == *name ) {
+                value = i->second.c_str();
+                break;
+              }
+            if( not value and not strchr( *name, '=' ) )
+              value = getenv( *name );
+
+            if( value ) {
+              out.write( value );
+              out.put( '\n' );
+            } else {
+              status = 1;
+            }
+          }
+          break;
+        }
+
+        default :
+          break;
+      }
+
+      if( output_failed() )
+        status = 1;
+
+      if( journal() )
+        journal()->record( key, status, run_journal::now() - started );
+
+      if( status ) {
+        // This might be the end.
+        out.flush();
+        handle_exit_status( status );
+      }
+    }
+
+    /*
+     * Splitting into files
+     */
+    void handle_node_split( xmlNodePtr node ) {
+      env_list env;
+      node_environment( node, env );
+      if( shards ) {
+        char shard[ 16 ];
+        snprintf( shard, sizeof( shard ), "%d", num_split % shards );
+        env.push_back( std::make_pair( std::string( "XMLSHARD" ), std::string( shard ) ) );
+      }
+      ++num_split;
+
+      const char *data = toChar( serialize_node( node ) );
+      std::string name = expand_template( env );
+      splitter.write( name, data, strlen( data ) );
+      splitter.write( name, "\n", 1 );
+    }
+
+    std::string expand_template( const env_list &env ) {
+      std::string name;
+      const char *t = split_template.c_str();
+      while( *t ) {
+        if( '$' != *t or not t[1] ) {
+          name += *t++;
+          continue;
+        }
+
+        ++t;
+        std::string var;
+        if( '$' == *t ) {
+          name += *t++;
+          continue;
+        } else if( '{' == *t ) {
+          const char *close = strchr( t, '}' );
+          if( not close ) {
+            // Not a reference after all
+            name += '$';
+            continue;
+          }
+          var.assign( t + 1, close );
+          t = close + 1;
+        } else {
+          const char *b = t;
+          while( isalnum( *t ) or '_' == *t )
+            ++t;
+          if( b == t ) {
+            name += '$';
+            continue;
+          }
+          var.assign( b, t );
+        }
+
+        const std::string *value = NULL;
+        for( env_list::const_reverse_iterator i = env.rbegin(); i != env.rend(); ++i )
+          if( i->first == var ) {
+            value = &i->second;
+            break;
+          }
+
+        // Anything else could write to a file the template doesn't name or
+        // quietly put different elements in the same file.
+        if( not value ) {
+          std::cerr << "--split: $" << var << " is not set for <" << env.front().second << ">" << std::endl;
+          splitter.close_all();
+          exit(1);
+        }
+        if( value->empty() or "." == *value or ".." == *value ) {
+          std::cerr << "--split: $" << var << " is '" << *value << "' for <"
+                    << env.front().second << "> which can't be used in a file name" << std::endl;
+          splitter.close_all();
+          exit(1);
+        }
+
+        for( std::string::const_iterator c = value->begin(); c != value->end(); ++c )
+          name += '/' == *c ? '_' : *c;
+      }
+      return name;
+    }
+
+    /*
+     * Persistent worker pool
+     */
+    struct worker {
+      worker() : pid( 0 ), input( -1 ), status( -1 ), busy( false ) {}
+
+      pid_t       pid;
+      int         input;   // Write end of the worker's stdin
+      int         status;  // Read end of the status back-channel
+      bool        busy;
+      std::string line;    // Partial status line
+    };
+
+    void handle_node_persistent( xmlNodePtr node ) {
+      worker &w = idle_worker();
+
+      xmlBufferPtr buf = xmlBufferCreate();
+      xmlNodeDump( buf, node->doc, node, 0, 0 );
+      xmlBufferAdd( buf, toXmlChar( "" ), 1 );
+
+      // If the worker has gone away the write fails.  That is noticed as
+      // end of file on its status channel and counted as a failure there.
+      write_all( w.input, xmlBufferContent( buf ), xmlBufferLength( buf ) );
+      w.busy = true;
+
+      xmlBufferFree( buf );
+    }
+
+    worker &idle_worker() {
+      if( workers.empty() ) {
+        // The parent must survive writing to a worker that has died.
+        signal( SIGPIPE, SIG_IGN );
+        workers.resize( process_handler::max_procs() );
+      }
+
+      while( true ) {
+        for( typename std::vector<worker>::iterator i = workers.begin(); i != workers.end(); ++i ) {
+          if( not i->pid )
+            start_worker( *i );
+          if( not i->busy )
+            return *i;
+        }
+        wait_for_status();
+      }
+    }
+
+    void start_worker( worker &w ) {
+      int in[2], st[2];
+      if( pipe2( in, O_CLOEXEC ) or pipe2( st, O_CLOEXEC ) ) {
+        errno_msg( "pipe" );
+        abort();
+      }
+
+      w.pid    = spawn_program( get_argv(), in[0], st[1] );
+      w.input  = in[1];
+      w.status = st[0];
+      w.busy   = false;
+      w.line.clear();
+
+      close( in[0] );
+      close( st[1] );
+    }
+
+    /*
+     * Blocks until at least one busy worker reports a status or goes away.
+     */
+    void wait_for_status() {
+      std::vector<struct pollfd> fds;
+      std::vector<worker*>       polled;
+      for( typename std::vector<worker>::iterator i = workers.begin(); i != workers.end(); ++i )
+        if( i->busy ) {
+          struct pollfd pfd = { i->status, POLLIN, 0 };
+          fds.push_back( pfd );
+          polled.push_back( &*i );
+        }
+
+      if( fds.empty() )
+        return;
+
+      if( -1 == poll( &fds[0], fds.size(), -1 ) ) {
+        if( EINTR == errno )
+          return;
+        errno_msg( "poll" );
+        abort();
+      }
+
+      for( size_t i = 0; i < fds.size(); ++i )
+        if( fds[i].revents )
+          read_status( *polled[i] );
+    }
+
+    void read_status( worker &w ) {
+      char buf[ 64 ];
+      ssize_t num = read( w.status, buf, sizeof( buf ) );
+      if( -1 == num and EINTR == errno )
+        return;
+
+      if( 0 < num ) {
+        for( char *c = buf; c != buf + num; ++c )
+          if( '\n' == *c ) {
+            w.busy = false;
+            handle_exit_status( atoi( w.line.c_str() ) );
+            w.line.clear();
+          } else {
+            w.line += *c;
+          }
+        return;
+      }
+
+      // The worker went away.  Its own exit status is applied when it is
+      // reaped.  A record it never answered for counts as a failure.
+      close( w.input );
+      close( w.status );
+      bool lost_record = w.busy;
+      pid_t pid = w.pid;
+      w = worker();
+      reap_process( pid );
+      if( lost_record )
+        handle_exit_status( 1 );
+    }
+
+    void stop_workers() {
+      for( typename std::vector<worker>::iterator i = workers.begin(); i != workers.end(); ++i )
+        while( i->pid and i->busy )
+          wait_for_status();
+
+      for( typename std::vector<worker>::iterator i = workers.begin(); i != workers.end(); ++i )
+        if( i->pid ) {
+          close( i->input );
+          close( i->status );
+          *i = worker();
+        }
+      workers.clear();
+    }
+
+    static void write_all( int fd, const xmlChar *data, int len ) {
+      while( 0 < len ) {
+        ssize_t num = write( fd, data, len );
+        if( -1 == num ) {
+          if( EINTR == errno )
+            continue;
+          return;
+        }
+        data += num;
+        len  -= num;
+      }
+    }
+
+    /*
+     * True once a write to out has failed.  The error is printed the first
+     * time.  Whatever wrote there should fail the way a command whose
+     * output couldn't be written would have.
+     */
+    bool output_failed() {
+      if( not out.error() )
+        return false;
+      if( not output_error_reported ) {
+        output_error_reported = true;
+        std::cerr << "Couldn't write output: " << strerror( out.error() ) << std::endl;
+      }
+      return true;
+    }
+
+    // In-process output such as that of the built-in commands
+    output_sink out;
+
   private:
     // Options
     bool printroot;
+    bool persistent;
+    builtin_command builtin;
+    std::string split_template;
+    int shards;
+    int num_split;
+    split_writer splitter;
+
+    std::vector<worker> workers;
+    std::deque<ready_job> ready;
+
+    // Finds each element's key in the journal
+    xmlXPathContextPtr  keyctx;
+    xmlXPathCompExprPtr keycomp;
+    // How many elements with each content key have been found
+    name_table<size_t>  content_keys;
+
+    // The soft limit on open files
+    size_t open_files;
+
+    bool output_error_reported;
 
     basic_marcher();
     basic_marcher( const basic_marcher& );
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+# Reads NUL separated records as sent by xmlforeach --persistent and reports
+# the status of each one on file descriptor 3.
+while IFS= read -r -d '' record; do
+  name=$(echo "$record" | sed -n 's:.*<name>\(.*\)</name>.*:\1:p')
+  echo $name
+  test "$name" != "$PERSIST_FAIL"
+  echo $? >&3
+done
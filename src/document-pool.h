@@ -0,0 +1,211 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef DOCUMENT_POOL_H
+#define DOCUMENT_POOL_H
+
+#include <pthread.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/xpath.h>
+
+#include "xml-util.h"
+
+/*
+ * Parses whole documents on a pool of threads and finds the nodes in each
+ * that match an XPath expression.  Each thread has its own parser and its
+ * own compiled copy of the expression; nothing from libxml2 is shared.
+ *
+ * Documents are handed back with take() either in the order they were
+ * submitted or in the order they finish.  What is done with the matches,
+ * and freeing the document, is up to the caller.  Only one thread may call
+ * submit() and take().
+ *
+ * With no threads the documents are parsed in submit() itself.
+ */
+class document_pool {
+  public:
+    struct document {
+      document() : begin( NULL ), end( NULL ), doc( NULL ), parsed( false ) {}
+
+      const char              *begin, *end;
+      std::string              data;     // Holds the input unless it is mapped
+      xmlDocPtr                doc;      // NULL if it failed to parse
+      std::vector<xmlNodePtr>  matches;
+      bool                     parsed;
+    };
+
+    document_pool( const char *expression, int num_threads, bool ordered )
+      : expression( expression ),
+        ordered( ordered ),
+        stopping( false ),
+        inline_comp( NULL )
+    {
+      xmlInitParser();
+
+      pthread_mutex_init( &lock, NULL );
+      pthread_cond_init( &work_ready, NULL );
+      pthread_cond_init( &work_done,  NULL );
+
+      if( num_threads <= 1 ) {
+        inline_comp = xmlXPathCompile( toXmlChar( expression ) );
+        return;
+      }
+
+      threads.resize( num_threads );
+      for( std::vector<pthread_t>::iterator i = threads.begin(); i != threads.end(); ++i ) {
+        int rc = pthread_create( &*i, NULL, run_worker, this );
+        if( rc ) {
+          std::cerr << "Couldn't start a parse thread: " << strerror( rc ) << std::endl;
+          exit(1);
+        }
+      }
+    }
+
+    ~document_pool() {
+      pthread_mutex_lock( &lock );
+      stopping = true;
+      pthread_cond_broadcast( &work_ready );
+      pthread_mutex_unlock( &lock );
+
+      for( std::vector<pthread_t>::iterator i = threads.begin(); i != threads.end(); ++i )
+        pthread_join( *i, NULL );
+
+      for( std::deque<document*>::iterator i = submitted.begin(); i != submitted.end(); ++i ) {
+        if( (*i)->doc )
+          xmlFreeDoc( (*i)->doc );
+        delete *i;
+      }
+
+      if( inline_comp )
+        xmlXPathFreeCompExpr( inline_comp );
+      pthread_cond_destroy( &work_done );
+      pthread_cond_destroy( &work_ready );
+      pthread_mutex_destroy( &lock );
+    }
+
+    // Documents that have been submitted and not taken back yet
+    size_t pending() {
+      return submitted.size();
+    }
+
+    // A bound on pending() that keeps every thread busy
+    size_t max_pending() {
+      return 4 * ( threads.empty() ? 1 : threads.size() );
+    }
+
+    void submit( document *d ) {
+      if( threads.empty() ) {
+        parse( d, inline_comp );
+        d->parsed = true;
+        submitted.push_back( d );
+        return;
+      }
+
+      pthread_mutex_lock( &lock );
+      submitted.push_back( d );
+      waiting.push_back( d );
+      pthread_cond_signal( &work_ready );
+      pthread_mutex_unlock( &lock );
+    }
+
+    /*
+     * Returns the next document that is done or NULL if there isn't one
+     * yet.  With block it waits for one unless nothing is pending at all.
+     */
+    document *take( bool block ) {
+      pthread_mutex_lock( &lock );
+      document *d = NULL;
+      while( not submitted.empty() ) {
+        if( ordered ) {
+          if( submitted.front()->parsed ) {
+            d = submitted.front();
+            submitted.pop_front();
+          }
+        } else {
+          for( std::deque<document*>::iterator i = submitted.begin(); i != submitted.end(); ++i )
+            if( (*i)->parsed ) {
+              d = *i;
+              submitted.erase( i );
+              break;
+            }
+        }
+
+        if( d or not block )
+          break;
+        pthread_cond_wait( &work_done, &lock );
+      }
+      pthread_mutex_unlock( &lock );
+      return d;
+    }
+
+  private:
+    static void *run_worker( void *arg ) {
+      document_pool *self = static_cast<document_pool*>( arg );
+      xmlXPathCompExprPtr comp = xmlXPathCompile( toXmlChar( self->expression ) );
+
+      pthread_mutex_lock( &self->lock );
+      while( true ) {
+        while( self->waiting.empty() and not self->stopping )
+          pthread_cond_wait( &self->work_ready, &self->lock );
+        if( self->waiting.empty() )
+          break;
+
+        document *d = self->waiting.front();
+        self->waiting.pop_front();
+        pthread_mutex_unlock( &self->lock );
+
+        parse( d, comp );
+
+        pthread_mutex_lock( &self->lock );
+        d->parsed = true;
+        pthread_cond_signal( &self->work_done );
+      }
+      pthread_mutex_unlock( &self->lock );
+
+      xmlXPathFreeCompExpr( comp );
+      return NULL;
+    }
+
+    static void parse( document *d, xmlXPathCompExprPtr comp ) {
+      d->doc = xmlReadMemory( d->begin, d->end - d->begin, NULL, NULL, 0 );
+      if( d->doc and comp ) {
+        xmlXPathContextPtr ctx = xmlXPathNewContext( d->doc );
+        xmlXPathObjectPtr  obj = xmlXPathCompiledEval( comp, ctx );
+        if( obj ) {
+          xmlNodeSetPtr nodes = obj->nodesetval;
+          if( nodes and nodes->nodeNr )
+            d->matches.assign( nodes->nodeTab, nodes->nodeTab + nodes->nodeNr );
+          xmlXPathFreeObject( obj );
+        }
+        xmlXPathFreeContext( ctx );
+      }
+    }
+
+    const char *expression;
+    bool        ordered;
+    bool        stopping;
+
+    std::vector<pthread_t>  threads;
+    pthread_mutex_t         lock;
+    pthread_cond_t          work_ready, work_done;
+
+    // Every pending document in the order it was submitted and those that
+    // no thread has started on yet.
+    std::deque<document*>   submitted, waiting;
+
+    xmlXPathCompExprPtr     inline_comp;
+
+    document_pool( const document_pool& );
+};
+
+#endif
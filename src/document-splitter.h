@@ -0,0 +1,169 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef DOCUMENT_SPLITTER_H
+#define DOCUMENT_SPLITTER_H
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+/*
+ * Finds where one document ends in input that holds many of them one after
+ * the other.  Documents either end at a delimiter (a NUL byte, a line of
+ * dashes, ...) or just after the close of their root element.
+ *
+ * Finding the root's close only takes a light scan of the markup: tags are
+ * counted and comments, processing instructions, CDATA sections and the
+ * DOCTYPE are skipped.  Nothing is checked for being well-formed; that is
+ * left to the parser.
+ *
+ * The input for one document may arrive a piece at a time.  next() is called
+ * again with the same start and a later end until it finds the end.  It
+ * remembers how far it got so nothing is scanned twice.
+ */
+class document_splitter {
+  public:
+    document_splitter() : at_root( true ) {
+      reset();
+    }
+
+    void set_delimiter( const std::string &delim ) {
+      at_root   = delim.empty();
+      delimiter = delim;
+    }
+
+    /*
+     * Looks for the end of the document that starts at b.  Returns where
+     * the next one starts or NULL if the end isn't in [b,e) yet.  doc_end is
+     * set to the end of the document itself, which is before the delimiter.
+     */
+    const char *next( const char *b, const char *e, const char *&doc_end ) {
+      const char *found = at_root ? scan_markup( b, e ) : scan_delimiter( b, e );
+      if( not found )
+        return NULL;
+
+      doc_end = found;
+      reset();
+      return at_root ? found : found + delimiter.size();
+    }
+
+  private:
+    void reset() {
+      scanned   = 0;
+      depth     = 0;
+      seen_root = false;
+    }
+
+    const char *scan_delimiter( const char *b, const char *e ) {
+      // The delimiter may have been cut in two by the end of the last piece.
+      size_t from = scanned < delimiter.size() ? 0 : scanned - delimiter.size() + 1;
+      const char *found = std::search( b + from, e, delimiter.begin(), delimiter.end() );
+      if( found != e )
+        return found;
+
+      scanned = e - b;
+      return NULL;
+    }
+
+    const char *scan_markup( const char *b, const char *e ) {
+      const char *p = b + scanned;
+      while( p != e ) {
+        if( '<' != *p ) {
+          const char *lt = static_cast<const char*>( memchr( p, '<', e - p ) );
+          p = lt ? lt : e;
+          continue;
+        }
+
+        // Wait for enough to tell what kind of markup this is.
+        if( e - p < 2 or ( '!' == p[1] and e - p < 9 ) )
+          break;
+
+        const char *close;
+        if( starts( p, "<?" ) )
+          close = find( p + 2, e, "?>" );
+        else if( starts( p, "<!--" ) )
+          close = find( p + 4, e, "-->" );
+        else if( starts( p, "<![CDATA[" ) )
+          close = find( p + 9, e, "]]>" );
+        else if( starts( p, "<!" ) )
+          close = end_of_declaration( p + 2, e );
+        else
+          close = end_of_tag( p + 1, e );
+
+        if( not close )
+          break;
+
+        if( '/' == p[1] ) {
+          --depth;
+        } else if( '?' != p[1] and '!' != p[1] ) {
+          seen_root = true;
+          if( '/' != close[-2] )
+            ++depth;
+        }
+        p = close;
+
+        if( seen_root and depth <= 0 )
+          return p;
+      }
+
+      scanned = p - b;
+      return NULL;
+    }
+
+    static bool starts( const char *p, const char *prefix ) {
+      return not strncmp( p, prefix, strlen( prefix ) );
+    }
+
+    // Returns the position just past the terminator or NULL
+    static const char *find( const char *p, const char *e, const char *term ) {
+      const char *found = std::search( p, e, term, term + strlen( term ) );
+      return found == e ? NULL : found + strlen( term );
+    }
+
+    // Finds the '>' that ends a tag, skipping quoted attribute values.
+    static const char *end_of_tag( const char *p, const char *e ) {
+      char quote = 0;
+      for( ; p != e; ++p )
+        if( quote ) {
+          if( quote == *p ) quote = 0;
+        } else if( '"' == *p or '\'' == *p ) {
+          quote = *p;
+        } else if( '>' == *p ) {
+          return p + 1;
+        }
+      return NULL;
+    }
+
+    // Same as end_of_tag() but a DOCTYPE may have an internal subset.
+    static const char *end_of_declaration( const char *p, const char *e ) {
+      char quote = 0;
+      int  brackets = 0;
+      for( ; p != e; ++p )
+        if( quote ) {
+          if( quote == *p ) quote = 0;
+        } else if( '"' == *p or '\'' == *p ) {
+          quote = *p;
+        } else if( '[' == *p ) {
+          ++brackets;
+        } else if( ']' == *p ) {
+          --brackets;
+        } else if( '>' == *p and brackets <= 0 ) {
+          return p + 1;
+        }
+      return NULL;
+    }
+
+    bool        at_root;
+    std::string delimiter;
+
+    // How far the current document has been scanned
+    size_t scanned;
+    int    depth;
+    bool   seen_root;
+};
+
+#endif
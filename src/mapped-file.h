@@ -0,0 +1,64 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * A read-only memory mapping of a whole regular file.  The parser can be fed
+ * straight from the mapping instead of copying the file through an istream.
+ *
+ * map() returns false for anything that can't be mapped (pipes, terminals,
+ * empty files, ...) so that the caller can fall back to reading a stream.
+ */
+class mapped_file {
+  public:
+    mapped_file() : addr( NULL ), length( 0 ) {}
+
+    ~mapped_file() {
+      if( addr )
+        munmap( addr, length );
+    }
+
+    bool map( const char *path ) {
+      int fd = open( path, O_RDONLY );
+      if( -1 == fd )
+        return false;
+
+      struct stat st;
+      if( 0 == fstat( fd, &st ) and S_ISREG( st.st_mode ) and 0 < st.st_size ) {
+        void *a = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( MAP_FAILED != a ) {
+          addr   = a;
+          length = st.st_size;
+          // The parser reads front to back exactly once.
+          madvise( addr, length, MADV_SEQUENTIAL );
+        }
+      }
+
+      close( fd );
+      return mapped();
+    }
+
+    bool mapped() const { return addr; }
+
+    const char *begin() const { return static_cast<const char*>( addr ); }
+    const char *end()   const { return begin() + length; }
+    size_t      size()  const { return length; }
+
+  private:
+    void   *addr;
+    size_t  length;
+
+    mapped_file( const mapped_file& );
+};
+
+#endif
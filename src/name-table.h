@@ -0,0 +1,139 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <stdint.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * Maps names to values.  Names are copied once into one growing arena and
+ * looked up in an open addressed hash table that only holds indexes of
+ * entries, so a lookup is a hash, a probe or two and a memcmp with no
+ * allocation.  Names are never removed.  Each one keeps the index it was
+ * added at so it can be found again without the text.
+ */
+template< class Value >
+class name_table {
+  public:
+    name_table() {
+      slots.resize( 64 );
+    }
+
+    /*
+     * Finds the value for the name, adding it with a default value if it
+     * isn't there yet.  added says which happened and index is where the
+     * name is.  The reference is good until the next name is added.
+     */
+    Value &intern( const char *name, size_t length, bool &added, size_t &index ) {
+      uint32_t h = hash( name, length );
+      size_t   i = find( name, length, h );
+
+      added = 0 == slots[ i ].entry;
+      if( not added ) {
+        index = slots[ i ].entry - 1;
+        return entries[ index ].value;
+      }
+
+      entry e;
+      e.offset = arena.size();
+      e.length = length;
+      entries.push_back( e );
+      arena.insert( arena.end(), name, name + length );
+
+      // Growing moves the slots around so i is no good after it.
+      index = entries.size() - 1;
+      slots[ i ].hash  = h;
+      slots[ i ].entry = entries.size();
+      if( 2 * entries.size() > slots.size() )
+        grow();
+
+      return entries[ index ].value;
+    }
+
+    Value &intern( const char *name, bool &added, size_t &index ) {
+      return intern( name, strlen( name ), added, index );
+    }
+
+    // The value for the name or NULL if it was never added
+    const Value *find( const char *name, size_t length ) const {
+      const slot &s = slots[ find( name, length, hash( name, length ) ) ];
+      return s.entry ? &entries[ s.entry - 1 ].value : NULL;
+    }
+
+    std::string name( size_t index ) const {
+      const entry &e = entries[ index ];
+      return std::string( arena.begin() + e.offset, arena.begin() + e.offset + e.length );
+    }
+
+    size_t size() const {
+      return entries.size();
+    }
+
+  private:
+    struct entry {
+      entry() : offset( 0 ), length( 0 ), value() {}
+
+      size_t offset, length;
+      Value  value;
+    };
+
+    struct slot {
+      slot() : hash( 0 ), entry( 0 ) {}
+
+      uint32_t hash;
+      uint32_t entry;   // One past the index of the entry, 0 if empty
+    };
+
+    // FNV-1a
+    static uint32_t hash( const char *name, size_t length ) {
+      uint32_t h = 2166136261u;
+      for( size_t i = 0; i < length; ++i ) {
+        h ^= static_cast<unsigned char>( name[i] );
+        h *= 16777619u;
+      }
+      return h;
+    }
+
+    // The slot holding the name or the empty one where it belongs.  The
+    // table size is a power of two and is never more than half full.
+    size_t find( const char *name, size_t length, uint32_t h ) const {
+      size_t mask = slots.size() - 1;
+      for( size_t i = h & mask; ; i = ( i + 1 ) & mask ) {
+        const slot &s = slots[ i ];
+        if( 0 == s.entry )
+          return i;
+        const entry &e = entries[ s.entry - 1 ];
+        if( s.hash == h and e.length == length
+            and ( 0 == length or 0 == memcmp( &arena[ e.offset ], name, length ) ) )
+          return i;
+      }
+    }
+
+    void grow() {
+      std::vector<slot> old( 2 * slots.size() );
+      old.swap( slots );
+
+      size_t mask = slots.size() - 1;
+      for( typename std::vector<slot>::const_iterator s = old.begin(); s != old.end(); ++s )
+        if( s->entry ) {
+          size_t i = s->hash & mask;
+          while( slots[ i ].entry )
+            i = ( i + 1 ) & mask;
+          slots[ i ] = *s;
+        }
+    }
+
+    std::vector<char>  arena;
+    std::vector<entry> entries;
+    std::vector<slot>  slots;
+};
+
+#endif
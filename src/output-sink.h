@@ -0,0 +1,115 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+/*
+ * A write buffer in front of a file descriptor for output that is produced in
+ * process.  Small writes are collected until the buffer fills.  A write that
+ * is too big to be worth copying goes out together with whatever is already
+ * buffered in a single writev().
+ *
+ * Nothing is written until the buffer fills, flush() is called or the sink is
+ * destroyed.  A write that fails is dropped and its errno is kept for error()
+ * so that the owner can report it once it is done writing.
+ */
+class output_sink {
+  public:
+    output_sink( int fd = 1, size_t capacity = 64 * 1024 )
+      : fd( fd ), buffer( capacity ), used( 0 ), write_errno( 0 ) {}
+
+    ~output_sink() {
+      flush();
+    }
+
+    void put( char c ) {
+      if( used == buffer.size() )
+        flush();
+      buffer[ used++ ] = c;
+    }
+
+    void write( const char *data, size_t len ) {
+      if( len <= buffer.size() - used ) {
+        memcpy( &buffer[ used ], data, len );
+        used += len;
+      } else if( len < buffer.size() ) {
+        flush();
+        memcpy( &buffer[ 0 ], data, len );
+        used = len;
+      } else {
+        struct iovec iov[2];
+        iov[0].iov_base = &buffer[0];
+        iov[0].iov_len  = used;
+        iov[1].iov_base = const_cast<char*>( data );
+        iov[1].iov_len  = len;
+        write_all( iov, 2 );
+        used = 0;
+      }
+    }
+
+    void write( const char *str ) {
+      write( str, strlen( str ) );
+    }
+
+    void flush() {
+      if( 0 == used )
+        return;
+
+      struct iovec iov;
+      iov.iov_base = &buffer[0];
+      iov.iov_len  = used;
+      write_all( &iov, 1 );
+      used = 0;
+    }
+
+    // The errno of the first write that failed or 0 if none has
+    int error() const {
+      return write_errno;
+    }
+
+  private:
+    void write_all( struct iovec *iov, int count ) {
+      while( 0 < count ) {
+        ssize_t num = writev( fd, iov, count );
+        if( -1 == num ) {
+          if( EINTR == errno )
+            continue;
+          if( 0 == write_errno )
+            write_errno = errno;
+          return;
+        }
+
+        // Skip whatever was written completely and trim what was partly
+        // written.
+        while( 0 < count and iov->iov_len <= static_cast<size_t>( num ) ) {
+          num -= iov->iov_len;
+          ++iov;
+          --count;
+        }
+        if( 0 < count ) {
+          iov->iov_base = static_cast<char*>( iov->iov_base ) + num;
+          iov->iov_len -= num;
+        }
+      }
+    }
+
+    int               fd;
+    std::vector<char> buffer;
+    size_t            used;
+    int               write_errno;
+
+    output_sink( const output_sink& );
+};
+
+#endif
@@ -5,21 +5,60 @@
  * possession, use or copying.
  */
 #include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdlib.h>
+#include <poll.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <string.h>
 
+#include <map>
 #include <utility>
+#include <vector>
 #include <cassert>
 #include <iostream>
 
 #include "process-handler.h"
+#include "run-journal.h"
+
+extern char **environ;
+
+spawn_environment::spawn_environment() {
+  for( char **var = environ; *var; ++var )
+    entries.push_back( *var );
+}
+
+bool spawn_environment::set( const std::string &name, const std::string &value ) {
+  if( name.empty() or std::string::npos != name.find( '=' ) )
+    return false;
+
+  std::string entry = name + "=" + value;
+  for( std::vector<std::string>::iterator i = entries.begin(); i != entries.end(); ++i )
+    if( 0 == i->compare( 0, name.size() + 1, entry, 0, name.size() + 1 ) ) {
+      i->swap( entry );
+      return true;
+    }
+
+  entries.push_back( entry );
+  return true;
+}
+
+char *const *spawn_environment::envp() {
+  pointers.clear();
+  for( std::vector<std::string>::iterator i = entries.begin(); i != entries.end(); ++i )
+    pointers.push_back( const_cast<char*>( i->c_str() ) );
+  pointers.push_back( NULL );
+  return &pointers[0];
+}
 
 process_handler::process_handler( const char **argv )
   : _argv( argv ),
     _verbose( false ),
+    _journal( NULL ),
     stop_on_error( false ),
     a_process_failed( false ),
     max_active_processes( 1 )
@@ -51,6 +90,15 @@ void process_handler::set_verbose( bool enabled ) {
   _verbose = enabled;
 }
 
+void process_handler::set_journal( run_journal *journal ) {
+  _journal = journal;
+}
+
+void process_handler::journal_job( pid_t pid, const std::string &key ) {
+  if( _journal )
+    journal_jobs[ pid ] = std::make_pair( key, run_journal::now() );
+}
+
 bool process_handler::processes_are_active() {
   return not active_processes.empty();
 }
@@ -72,22 +120,21 @@ std::pair<pid_t,int> process_handler::reap_process( pid_t pid ) {
     if( 0 < pid )
       assert( wpid == pid );
 
-    if( 255 == WEXITSTATUS( status ) )
-      exit(124);
+    // Written first because the status may end this process.
+    std::map< pid_t, std::pair<std::string,double> >::iterator job = journal_jobs.find( wpid );
+    if( job != journal_jobs.end() ) {
+      int code = WIFSIGNALED( status ) ? 128 + WTERMSIG( status ) : WEXITSTATUS( status );
+      _journal->record( job->second.first, code, run_journal::now() - job->second.second );
+      journal_jobs.erase( job );
+    }
 
     if( WIFSIGNALED( status ) )
       exit(125);
 
-    if( WEXITSTATUS( status ) ) {
-      if( 126 <= WEXITSTATUS( status ) )
-        exit( WEXITSTATUS( status ) );
-
-      if( 1 == max_active_processes and stop_on_error )
-        exit( 123 );
-      else
-        a_process_failed = true;
-    }
+    handle_exit_status( WEXITSTATUS( status ) );
     std::pair<pid_t,int> child = std::make_pair( wpid, WEXITSTATUS( status ) );
+    if( -1 != active_processes[ wpid ] )
+      close( active_processes[ wpid ] );
     active_processes.erase( wpid );
     post_reap_process( child );
     return child;
@@ -95,6 +142,106 @@ std::pair<pid_t,int> process_handler::reap_process( pid_t pid ) {
   return std::make_pair( 0, 0 );
 }
 
+int process_handler::reap_finished() {
+  bool readable;
+  return poll_finished( -1, 0, readable );
+}
+
+bool process_handler::wait_for_child_or_input( int fd ) {
+  bool readable;
+  poll_finished( fd, -1, readable );
+  return readable;
+}
+
+/*
+ * Polls the pidfds of the children, and fd if it isn't -1, for up to
+ * timeout milliseconds and reaps the children that have exited.  Returns the
+ * number reaped.
+ */
+int process_handler::poll_finished( int fd, int timeout, bool &readable ) {
+  std::vector<struct pollfd> fds;
+  std::vector<pid_t>         polled, ready;
+  bool                       unpolled = false;
+
+  std::map<pid_t,int>::const_iterator i;
+  for( i = active_processes.begin(); i != active_processes.end(); ++i ) {
+    if( -1 == i->second ) {
+      // No pidfd for this one so ask without consuming the status.
+      unpolled = true;
+      siginfo_t info;
+      info.si_pid = 0;
+      if( 0 == waitid( P_PID, i->first, &info, WEXITED | WNOHANG | WNOWAIT ) and info.si_pid )
+        ready.push_back( i->first );
+    } else {
+      struct pollfd pfd = { i->second, POLLIN, 0 };
+      fds.push_back( pfd );
+      polled.push_back( i->first );
+    }
+  }
+
+  // Children without a pidfd can only be checked on again after a while.
+  if( not ready.empty() )
+    timeout = 0;
+  else if( unpolled and timeout < 0 )
+    timeout = 10;
+
+  if( -1 != fd ) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    fds.push_back( pfd );
+  }
+
+  readable = false;
+  if( not fds.empty() ) {
+    int num = poll( &fds[0], fds.size(), timeout );
+    if( -1 == num and EINTR != errno ) {
+      errno_msg( "poll" );
+      abort();
+    }
+    if( 0 < num ) {
+      for( size_t j = 0; j < polled.size(); ++j )
+        if( fds[j].revents )
+          ready.push_back( polled[j] );
+      readable = -1 != fd and fds.back().revents;
+    }
+  }
+
+  for( std::vector<pid_t>::const_iterator p = ready.begin(); p != ready.end(); ++p )
+    reap_process( *p );
+
+  return ready.size();
+}
+
+bool process_handler::slot_available() {
+  return active_processes.size() < static_cast<size_t>( max_active_processes );
+}
+
+void process_handler::track_process( pid_t pid ) {
+  // A pidfd becomes readable when the child exits which lets
+  // reap_finished() check on every child with a single poll().
+  int fd = -1;
+#ifdef SYS_pidfd_open
+  fd = syscall( SYS_pidfd_open, pid, 0 );
+  if( -1 != fd )
+    fcntl( fd, F_SETFD, FD_CLOEXEC );
+#endif
+  active_processes[ pid ] = fd;
+}
+
+void process_handler::handle_exit_status( int status ) {
+  if( 255 == status )
+    exit(124);
+
+  if( status ) {
+    if( 126 <= status )
+      exit( status );
+
+    if( 1 == max_active_processes and stop_on_error )
+      exit( 123 );
+    else
+      a_process_failed = true;
+  }
+}
+
 /*
  * Spawns a child process to handle the current node
  *
@@ -112,8 +259,61 @@ pid_t process_handler::spawn_worker() {
   }
 
   if( pid )
-    active_processes.insert( pid );
+    track_process( pid );
+
+  return pid;
+}
 
+pid_t process_handler::spawn_program( const char **argv,
+                                      int input,
+                                      int channel,
+                                      spawn_environment *env,
+                                      int output ) {
+  // If the maximum number of processes has been reached then wait
+  if( not slot_available() )
+    reap_process();
+
+  if( verbose() )
+    print_command( argv );
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init( &actions );
+  if( -1 != input )
+    posix_spawn_file_actions_adddup2( &actions, input, 0 );
+  if( -1 != channel )
+    posix_spawn_file_actions_adddup2( &actions, channel, 3 );
+  if( -1 != output )
+    posix_spawn_file_actions_adddup2( &actions, output, 1 );
+
+  // The parent may be ignoring SIGPIPE but the child shouldn't be.
+  posix_spawnattr_t attr;
+  posix_spawnattr_init( &attr );
+  sigset_t defaults;
+  sigemptyset( &defaults );
+  sigaddset( &defaults, SIGPIPE );
+  posix_spawnattr_setsigdefault( &attr, &defaults );
+  posix_spawnattr_setflags( &attr, POSIX_SPAWN_SETSIGDEF );
+
+  pid_t pid;
+  int rc = posix_spawnp( &pid,
+                         argv[0],
+                         &actions,
+                         &attr,
+                         const_cast<char *const*>( argv ),
+                         env ? env->envp() : environ );
+
+  posix_spawnattr_destroy( &attr );
+  posix_spawn_file_actions_destroy( &actions );
+
+  if( rc ) {
+    // Same as a child that failed to exec.  Both statuses exit.
+    switch( rc ) {
+      case ENOENT : handle_exit_status( 127 ); break;
+      default     : handle_exit_status( 126 ); break;
+    }
+  }
+
+  track_process( pid );
   return pid;
 }
 
@@ -132,16 +332,19 @@ void process_handler::errno_msg( const char *name ) {
     << std::endl;
 }
 
-void process_handler::exec_program() {
-  if( verbose() ) {
-    const char **args = _argv;
-    while( *args ) {
-      if( args != _argv ) std::cerr << ' ';
-      std::cerr << *args;
-      ++args;
-    }
-    std::cerr << std::endl;
+void process_handler::print_command( const char **argv ) {
+  const char **args = argv;
+  while( *args ) {
+    if( args != argv ) std::cerr << ' ';
+    std::cerr << *args;
+    ++args;
   }
+  std::cerr << std::endl;
+}
+
+void process_handler::exec_program() {
+  if( verbose() )
+    print_command( _argv );
 
   execvp( _argv[0], const_cast<char**>(_argv) );
 
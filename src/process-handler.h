@@ -7,7 +7,31 @@
 #ifndef PROCESS_HANDLER_H
 #define PROCESS_HANDLER_H
 
-#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+class run_journal;
+
+/*
+ * The environment for a program started with spawn_program().  It starts as
+ * a copy of this process's environment and variables can be overridden just
+ * as setenv() would in a forked child.  Everything is prepared in the parent
+ * so that nothing needs to happen in the child between fork and exec.
+ */
+class spawn_environment {
+  public:
+    spawn_environment();
+
+    // Returns false if the name is not a valid variable name
+    bool set( const std::string &name, const std::string &value );
+    char *const *envp();
+
+  private:
+    std::vector<std::string> entries;
+    std::vector<char*>       pointers;
+};
 
 class process_handler {
   public:
@@ -23,6 +47,12 @@ class process_handler {
     void set_max_procs( int max );
     void set_verbose( bool enabled );
 
+    /*
+     * Each job that is started with a key from journal_job() is written to
+     * the journal when it is reaped.
+     */
+    void set_journal( run_journal *journal );
+
   protected:
     virtual void post_reap_process( std::pair<pid_t,int> ) {}
     virtual std::pair<pid_t,int> reap_process( pid_t pid = -1 );
@@ -33,13 +63,59 @@ class process_handler {
      * Returns true if we're in the parent process.
      */
     pid_t spawn_worker();
+    /*
+     * Starts argv as a new process without forking this one.  Waits for a
+     * free slot first, just like spawn_worker().  If input is not -1 it
+     * becomes the child's stdin, if channel is not -1 it becomes the child's
+     * file descriptor 3 and if output is not -1 it becomes the child's
+     * stdout.  The environment is inherited unless env is given.
+     *
+     * Returns the pid of the child.  If the program could not be run this
+     * exits with 126 or 127 just as a forked child would have.
+     */
+    pid_t spawn_program( const char **argv,
+                         int input = -1,
+                         int channel = -1,
+                         spawn_environment *env = NULL,
+                         int output = -1 );
     /*
      * Execs the program with the current argument list.
      */
     void exec_program();
+    void print_command( const char **argv );
     bool processes_are_active();
     void reap_all_active();
 
+    /*
+     * Reaps every child that has already exited without waiting for any
+     * others.  Returns the number reaped.
+     */
+    int  reap_finished();
+    /*
+     * Waits until a child exits or fd has input to read, whichever comes
+     * first, and reaps the children that have exited.  Returns true if fd
+     * is readable.
+     */
+    bool wait_for_child_or_input( int fd );
+    // True if another child can be started without waiting
+    bool slot_available();
+
+    /*
+     * Applies the exit status of one job to the overall result.  This exits
+     * right away for the statuses that stop everything (255, 126 and up).
+     */
+    void handle_exit_status( int status );
+
+    // The child pid is the job with this key.
+    void journal_job( pid_t pid, const std::string &key );
+    run_journal *journal() {
+      return _journal;
+    }
+
+    int max_procs() {
+      return max_active_processes;
+    }
+
     const char **get_argv() {
       return _argv;
     }
@@ -67,7 +143,15 @@ class process_handler {
     const char **_argv;
     bool _verbose;
 
-    std::set<pid_t> active_processes;
+    void track_process( pid_t pid );
+    int  poll_finished( int fd, int timeout, bool &readable );
+
+    // Each active child and its pidfd (-1 if pidfds aren't supported)
+    std::map<pid_t,int> active_processes;
+
+    // The key of each active child in the journal and when it started
+    run_journal *_journal;
+    std::map< pid_t, std::pair<std::string,double> > journal_jobs;
 
     // Options
     bool stop_on_error;
@@ -0,0 +1,168 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef READY_QUEUE_H
+#define READY_QUEUE_H
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+/*
+ * Decides which of the ready vertices of a StreamDfs graph to run next.
+ *
+ * By default they run in the order they became ready.  With the critical
+ * path on, the one with the most expensive chain of dependents waiting on
+ * it goes first so that long chains start early.  A vertex's rank is its
+ * own cost plus the highest rank of anything that depends on it.
+ *
+ * Ranks are kept up to date as vertices are found.  One that goes up is
+ * pushed down to the vertices it depends on that haven't started.  A vertex
+ * that is already in the heap keeps its old key until it reaches the top;
+ * then it is put back with the new one.
+ *
+ * When elements come before the ones they depend on, as in a hierarchy
+ * written from the top, the rank of a vertex is settled when it is found.
+ * Otherwise each one found may have to update the ranks below it.
+ */
+template< class Graph >
+class ready_queue {
+  public:
+    typedef typename boost::graph_traits< Graph >::vertex_descriptor vertex_descriptor;
+    typedef typename boost::graph_traits< Graph >::out_edge_iterator out_edge_iterator;
+    typedef typename boost::graph_traits< Graph >::in_edge_iterator  in_edge_iterator;
+
+    explicit ready_queue( Graph &g ) : g( g ), critical_path( false ), sequence( 0 ) {}
+
+    void set_critical_path( bool on ) {
+      critical_path = on;
+    }
+
+    /*
+     * Call this with the cost of v just before g.found_vertex( v ).  Costs
+     * should not be negative.
+     */
+    void found( vertex_descriptor v, double cost ) {
+      if( not critical_path )
+        return;
+
+      grow( v );
+      this->cost[ v ] = cost;
+
+      double r = cost;
+      std::pair<
+          in_edge_iterator,
+          in_edge_iterator
+        > edges = in_edges( v, g );
+      for( ; edges.first != edges.second; ++edges.first ) {
+        vertex_descriptor u = source( *edges.first, g );
+        if( u < rank.size() and 0 <= rank[ u ] )
+          r = std::max( r, cost + rank[ u ] );
+      }
+      rank[ v ] = r;
+
+      push_down( v );
+    }
+
+    /*
+     * Takes the next vertex to run from the graph's ready vertices.  Returns
+     * false if none are ready.
+     */
+    bool next( vertex_descriptor &v ) {
+      if( not critical_path ) {
+        if( g.ready.empty() )
+          return false;
+        v = g.ready.front();
+        g.ready.pop();
+        return true;
+      }
+
+      while( not g.ready.empty() ) {
+        vertex_descriptor u = g.ready.front();
+        g.ready.pop();
+        grow( u );
+        heap.push( entry( rank[ u ], sequence++, u ) );
+      }
+
+      while( not heap.empty() ) {
+        entry top = heap.top();
+        heap.pop();
+        if( rank[ top.v ] < 0 )
+          continue;
+        if( top.rank < rank[ top.v ] ) {
+          heap.push( entry( rank[ top.v ], top.sequence, top.v ) );
+          continue;
+        }
+
+        v = top.v;
+        rank[ v ] = started;
+        return true;
+      }
+      return false;
+    }
+
+  private:
+    static const int started = -1;
+
+    struct entry {
+      entry( double rank, unsigned long sequence, vertex_descriptor v )
+        : rank( rank ), sequence( sequence ), v( v ) {}
+
+      // Highest rank first, then the one that was ready first
+      bool operator<( const entry &other ) const {
+        if( rank != other.rank )
+          return rank < other.rank;
+        return sequence > other.sequence;
+      }
+
+      double            rank;
+      unsigned long     sequence;
+      vertex_descriptor v;
+    };
+
+    void grow( vertex_descriptor v ) {
+      if( rank.size() <= v ) {
+        rank.resize( v + 1, 0 );
+        cost.resize( v + 1, 0 );
+      }
+    }
+
+    // v's rank went up.  So may the ranks of what it depends on.
+    void push_down( vertex_descriptor v ) {
+      work.push_back( v );
+      while( not work.empty() ) {
+        vertex_descriptor u = work.back();
+        work.pop_back();
+
+        std::pair<
+            out_edge_iterator,
+            out_edge_iterator
+          > edges = out_edges( u, g );
+        for( ; edges.first != edges.second; ++edges.first ) {
+          vertex_descriptor t = target( *edges.first, g );
+          grow( t );
+          if( rank[ t ] < 0 or cost[ t ] + rank[ u ] <= rank[ t ] )
+            continue;
+          rank[ t ] = cost[ t ] + rank[ u ];
+          work.push_back( t );
+        }
+      }
+    }
+
+    Graph &g;
+    bool   critical_path;
+
+    // Per vertex.  A rank below zero means the vertex has started.
+    std::vector<double> rank, cost;
+
+    std::priority_queue<entry>     heap;
+    unsigned long                  sequence;
+    std::vector<vertex_descriptor> work;
+
+    ready_queue( const ready_queue& );
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef RUN_JOURNAL_H
+#define RUN_JOURNAL_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "name-table.h"
+
+/*
+ * A record of the jobs a run has finished so that a run that died can be
+ * started again without repeating them.  Each job is one line appended to
+ * the journal file:
+ *
+ *   <key> TAB <exit status> TAB <seconds> NEWLINE
+ *
+ * Tabs, newlines and backslashes in the key are written as \t, \n and \\.
+ *
+ * Every line goes out with a single write() as soon as the job is done so
+ * nothing is lost if this process dies.  Only the fsync() that protects it
+ * from the machine going down is put off until a number of lines have been
+ * written or some time has passed.
+ */
+class run_journal {
+  public:
+    run_journal( size_t sync_lines = 256, double sync_seconds = 1.0 )
+      : fd( -1 ),
+        sync_lines( sync_lines ),
+        sync_seconds( sync_seconds ),
+        unsynced( 0 ),
+        last_sync( now() ) {}
+
+    ~run_journal() {
+      sync();
+      if( -1 != fd )
+        close( fd );
+    }
+
+    /*
+     * Reads a journal from an earlier run and remembers the keys of the jobs
+     * that succeeded.  A last line without a newline was cut off when that
+     * run died and is ignored.
+     */
+    void load( const char *path ) {
+      int in = ::open( path, O_RDONLY | O_CLOEXEC );
+      if( -1 == in ) {
+        if( ENOENT == errno )
+          return;
+        std::cerr << "Couldn't open journal '" << path << "': " << strerror( errno ) << std::endl;
+        exit(1);
+      }
+
+      std::string data;
+      char buf[ 64 * 1024 ];
+      ssize_t num;
+      while( 0 != ( num = read( in, buf, sizeof( buf ) ) ) ) {
+        if( -1 == num ) {
+          if( EINTR == errno )
+            continue;
+          std::cerr << "Couldn't read journal '" << path << "': " << strerror( errno ) << std::endl;
+          exit(1);
+        }
+        data.append( buf, num );
+      }
+      close( in );
+
+      std::string key;
+      for( size_t begin = 0, end; std::string::npos != ( end = data.find( '\n', begin ) ); begin = end + 1 ) {
+        size_t tab = data.find( '\t', begin );
+        if( tab > end )
+          continue;
+        if( 0 != atoi( data.c_str() + tab + 1 ) )
+          continue;
+
+        unescape( data.data() + begin, data.data() + tab, key );
+        bool   added;
+        size_t index;
+        succeeded_keys.intern( key.data(), key.size(), added, index );
+      }
+    }
+
+    // Opens the journal for appending.  It is created if needed.
+    void open( const char *path ) {
+      fd = ::open( path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666 );
+      if( -1 == fd ) {
+        std::cerr << "Couldn't open journal '" << path << "' for writing: " << strerror( errno ) << std::endl;
+        exit(1);
+      }
+    }
+
+    // True if an earlier run finished the job with this key successfully
+    bool succeeded( const std::string &key ) const {
+      return NULL != succeeded_keys.find( key.data(), key.size() );
+    }
+
+    void record( const std::string &key, int status, double seconds ) {
+      if( -1 == fd )
+        return;
+
+      line.clear();
+      escape( key, line );
+      char fields[ 64 ];
+      snprintf( fields, sizeof( fields ), "\t%d\t%.3f\n", status, seconds );
+      line += fields;
+
+      const char *p = line.data();
+      size_t      left = line.size();
+      while( left ) {
+        ssize_t num = write( fd, p, left );
+        if( -1 == num ) {
+          if( EINTR == errno )
+            continue;
+          std::cerr << "Couldn't write journal: " << strerror( errno ) << std::endl;
+          exit(1);
+        }
+        p    += num;
+        left -= num;
+      }
+
+      if( ++unsynced >= sync_lines or now() - last_sync >= sync_seconds )
+        sync();
+    }
+
+    void sync() {
+      if( -1 == fd or 0 == unsynced )
+        return;
+      fsync( fd );
+      unsynced  = 0;
+      last_sync = now();
+    }
+
+    static double now() {
+      struct timespec ts;
+      clock_gettime( CLOCK_MONOTONIC, &ts );
+      return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    /*
+     * A key for an element that has nothing better: FNV-1a over its bytes
+     * written as 16 hex digits.
+     */
+    static std::string content_key( const char *data, size_t len ) {
+      unsigned long long h = 14695981039346656037ULL;
+      for( size_t i = 0; i < len; ++i ) {
+        h ^= static_cast<unsigned char>( data[i] );
+        h *= 1099511628211ULL;
+      }
+      char hex[ 17 ];
+      snprintf( hex, sizeof( hex ), "%016llx", h );
+      return hex;
+    }
+
+  private:
+    static void escape( const std::string &key, std::string &out ) {
+      for( std::string::const_iterator c = key.begin(); c != key.end(); ++c )
+        switch( *c ) {
+          case '\t' : out += "\\t";  break;
+          case '\n' : out += "\\n";  break;
+          case '\\' : out += "\\\\"; break;
+          default   : out += *c;     break;
+        }
+    }
+
+    static void unescape( const char *b, const char *e, std::string &key ) {
+      key.clear();
+      for( ; b != e; ++b ) {
+        if( '\\' != *b or b + 1 == e ) {
+          key += *b;
+          continue;
+        }
+        ++b;
+        key += 't' == *b ? '\t' : 'n' == *b ? '\n' : *b;
+      }
+    }
+
+    int    fd;
+    size_t sync_lines;
+    double sync_seconds;
+    size_t unsynced;
+    double last_sync;
+
+    name_table<bool> succeeded_keys;
+    std::string      line;
+
+    run_journal( const run_journal& );
+};
+
+#endif
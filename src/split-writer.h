@@ -0,0 +1,134 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef SPLIT_WRITER_H
+#define SPLIT_WRITER_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+
+#include "output-sink.h"
+
+/*
+ * Writes records into many output files by name.  Each file gets its own
+ * write buffer.  Only so many files are kept open at once; the one used
+ * least recently is flushed and closed to make room for another.
+ *
+ * A file is truncated the first time it is written and appended to if it
+ * has to be opened again after that.
+ *
+ * Errors writing or closing a file are printed when the file is closed and
+ * remembered for failed().
+ */
+class split_writer {
+  public:
+    split_writer( size_t max_open = 0, size_t buffer_size = 32 * 1024 )
+      : max_open( max_open ), buffer_size( buffer_size ), write_failed( false )
+    {
+      // By default use up to half of the descriptors this process may have.
+      if( 0 == this->max_open ) {
+        long open_max = sysconf( _SC_OPEN_MAX );
+        this->max_open = 0 < open_max ? std::min( open_max / 2, 256L ) : 64;
+      }
+    }
+
+    ~split_writer() {
+      close_all();
+    }
+
+    void write( const std::string &name, const char *data, size_t len ) {
+      file( name ).sink->write( data, len );
+    }
+
+    void close_all() {
+      while( not files.empty() )
+        close_file();
+    }
+
+    // True if some file couldn't be written or closed
+    bool failed() const {
+      return write_failed;
+    }
+
+  private:
+    struct open_file {
+      std::string  name;
+      int          fd;
+      output_sink *sink;
+    };
+
+    typedef std::list<open_file> lru_list;
+
+    /*
+     * Finds the open file for name, opening it if needed, and makes it the
+     * most recently used.
+     */
+    open_file &file( const std::string &name ) {
+      std::map<std::string, lru_list::iterator>::iterator i = by_name.find( name );
+      if( i != by_name.end() ) {
+        files.splice( files.begin(), files, i->second );
+        return files.front();
+      }
+
+      if( files.size() == max_open )
+        close_file();
+
+      int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+      flags |= seen.insert( name ).second ? O_TRUNC : O_APPEND;
+      int fd = open( name.c_str(), flags, 0666 );
+      if( -1 == fd ) {
+        std::cerr << "Couldn't open '" << name << "' for writing: " << strerror( errno ) << std::endl;
+        close_all();
+        exit(1);
+      }
+
+      open_file f;
+      f.name = name;
+      f.fd   = fd;
+      f.sink = new output_sink( fd, buffer_size );
+      files.push_front( f );
+      by_name[ name ] = files.begin();
+      return files.front();
+    }
+
+    // Closes the least recently used file.
+    void close_file() {
+      open_file &f = files.back();
+      f.sink->flush();
+      if( f.sink->error() ) {
+        std::cerr << "Couldn't write '" << f.name << "': " << strerror( f.sink->error() ) << std::endl;
+        write_failed = true;
+      }
+      delete f.sink;
+      if( -1 == close( f.fd ) ) {
+        std::cerr << "Couldn't close '" << f.name << "': " << strerror( errno ) << std::endl;
+        write_failed = true;
+      }
+      by_name.erase( f.name );
+      files.pop_back();
+    }
+
+    size_t max_open;
+    size_t buffer_size;
+
+    lru_list                                   files;
+    std::map<std::string, lru_list::iterator>  by_name;
+    std::set<std::string>                      seen;
+    bool                                       write_failed;
+
+    split_writer( const split_writer& );
+};
+
+#endif
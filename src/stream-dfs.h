@@ -8,6 +8,7 @@
 #define STREAM_DFS_H
 
 #include <queue>
+#include <vector>
 #include <algorithm>
 
 // This class adapts an existing BGL compatible graph.  Its job is to iterate
@@ -30,25 +31,215 @@ namespace boost {
   template< class Graph >
   class StreamDfs : public Graph {
     public:
-      // Remember the base graph can grow arbitrarily large.
+      typedef typename graph_traits< Graph >::vertex_descriptor vertex_descriptor;
+      typedef typename graph_traits< Graph >::out_edge_iterator out_edge_iterator;
+      typedef typename graph_traits< Graph >::in_edge_iterator  in_edge_iterator;
+
+      // Remember the base graph can grow arbitrarily large.  The state grows
+      // by doubling so that calling this after every new vertex is cheap.
       void resize_properties() {
-        int oldsize = hasoutedges.size();
-        int newsize = num_vertices( *this );
-        if( oldsize < newsize ) {
-          hasoutedges.resize( newsize, false );
-          waiting.resize(     newsize, 0 );
-          connected.resize(   newsize, false );
+        std::size_t newsize = num_vertices( *this );
+        if( state.size() < newsize ) {
+          if( state.capacity() < newsize )
+            state.reserve( std::max( newsize, 2 * state.capacity() ) );
+          state.resize( newsize );
         }
       }
       // Poor mans external properties.  I should probably follow the BGL
       // Property interfaces but I'm a little too lazy right now.
+      //
+      // Everything known about a vertex is packed together so that following
+      // an edge touches one cache line instead of one per property.
+      enum {
+        // * Whether this vertex has all its out edges
+        HAS_OUT_EDGES = 1,
+        // * Whether this vertex is fully connected
+        CONNECTED     = 2,
+        // * Whether this vertex or anything it depends on failed
+        FAILED        = 4
+      };
+
+      struct vertex_state {
+        vertex_state() : waiting( 0 ), flags( 0 ) {}
+
+        // * Number of adjacent vertices waiting to be complete
+        unsigned int  waiting;
+        unsigned char flags;
+      };
+
+      std::vector<vertex_state> state;
+
+      bool has_out_edges( vertex_descriptor v ) const { return state[ v ].flags & HAS_OUT_EDGES; }
+      bool is_connected(  vertex_descriptor v ) const { return state[ v ].flags & CONNECTED; }
+      bool has_failed(    vertex_descriptor v ) const { return state[ v ].flags & FAILED; }
+
+      /*
+       * The rest of this is for running each vertex as soon as everything it
+       * depends on has been run.  A vertex becomes connected when it has been
+       * run successfully.  The vertex iterator below uses the same state and
+       * connects each vertex as it visits it, so don't mix the two.
+       *
+       * Vertices whose out edges are all known and whose targets are all
+       * connected are put in 'ready'.
+       */
+      std::queue<vertex_descriptor> ready;
+
+      // All of the out edges of v have been added.
+      void found_vertex( vertex_descriptor v ) {
+        resize_properties();
+        vertex_state &s = state[ v ];
+        if( s.flags & HAS_OUT_EDGES )
+          return;
+        s.flags |= HAS_OUT_EDGES;
+
+        bool depends_on_failure = false;
+        std::pair<
+            out_edge_iterator,
+            out_edge_iterator
+          > edges = out_edges( v, *this );
+        for( ; edges.first != edges.second; ++edges.first ) {
+          unsigned char t = state[ target( *edges.first, *this ) ].flags;
+          if( t & FAILED )
+            depends_on_failure = true;
+          else if( not ( t & CONNECTED ) )
+            ++s.waiting;
+        }
+
+        if( depends_on_failure )
+          mark_failed( v );
+        else if( 0 == s.waiting )
+          ready.push( v );
+      }
+
+      // v has been run successfully.  Its sources may be ready now.
+      void mark_connected( vertex_descriptor v ) {
+        resize_properties();
+        if( state[ v ].flags & CONNECTED )
+          return;
+        state[ v ].flags |= CONNECTED;
+
+        std::pair<
+            in_edge_iterator,
+            in_edge_iterator
+          > edges = in_edges( v, *this );
+        for( ; edges.first != edges.second; ++edges.first ) {
+          vertex_descriptor u = source( *edges.first, *this );
+          vertex_state &s = state[ u ];
+          if( HAS_OUT_EDGES == ( s.flags & ( HAS_OUT_EDGES | FAILED ) ) and 0 == --s.waiting )
+            ready.push( u );
+        }
+      }
+
+      // v failed.  Everything that depends on it, directly or not, fails
+      // with it.  Each one is added to 'newly_failed'.  Chains of dependencies
+      // can be far deeper than the stack so this keeps its own.
+      void mark_failed( vertex_descriptor v ) {
+        resize_properties();
+        if( state[ v ].flags & FAILED )
+          return;
+        state[ v ].flags |= FAILED;
+        newly_failed.push_back( v );
+
+        // Everything between here and the end of newly_failed still needs
+        // its in edges followed.
+        for( std::size_t i = newly_failed.size() - 1; i < newly_failed.size(); ++i ) {
+          std::pair<
+              in_edge_iterator,
+              in_edge_iterator
+            > edges = in_edges( newly_failed[ i ], *this );
+          for( ; edges.first != edges.second; ++edges.first ) {
+            vertex_descriptor u = source( *edges.first, *this );
+            if( not ( state[ u ].flags & FAILED ) ) {
+              state[ u ].flags |= FAILED;
+              newly_failed.push_back( u );
+            }
+          }
+        }
+      }
+
+      std::vector<vertex_descriptor> newly_failed;
+
+      /*
+       * Finds the vertices that can never run because they are part of a
+       * cycle.  Only vertices that have all their out edges but were never
+       * connected and never failed are looked at.  Each strongly connected
+       * component of more than one of them is added to 'cycles'.
+       *
+       * This is Tarjan's algorithm with its own stack instead of recursion.
+       * It is linear in the vertices and edges that are stuck.
+       */
+      void find_cycles( std::vector< std::vector<vertex_descriptor> > &cycles ) const {
+        const unsigned int unvisited = ~0u;
+        std::vector<unsigned int> index( state.size(), unvisited ), low( state.size() );
+        std::vector<bool>         on_stack( state.size(), false );
+        std::vector<vertex_descriptor> component;
+        std::vector< std::pair<vertex_descriptor, out_edge_iterator> > path;
+        unsigned int next_index = 0;
+
+        for( vertex_descriptor root = 0; root < state.size(); ++root ) {
+          if( not stuck( root ) or unvisited != index[ root ] )
+            continue;
+
+          vertex_descriptor v = root;
+          while( true ) {
+            if( unvisited == index[ v ] ) {
+              // First time here
+              index[ v ] = low[ v ] = next_index++;
+              component.push_back( v );
+              on_stack[ v ] = true;
+              path.push_back( std::make_pair( v, out_edges( v, *this ).first ) );
+            }
+
+            vertex_descriptor u = path.back().first;
+            out_edge_iterator &e = path.back().second;
+            if( e != out_edges( u, *this ).second ) {
+              vertex_descriptor w = target( *e, *this );
+              ++e;
+              if( not stuck( w ) )
+                continue;
+              if( unvisited == index[ w ] )
+                v = w;
+              else if( on_stack[ w ] )
+                low[ u ] = std::min( low[ u ], index[ w ] );
+              continue;
+            }
 
-      // * Whether this vertex has all its out edges
-      std::vector<bool> hasoutedges;
-      // * Number of adjacent vertices waiting to be complete
-      std::vector<int>  waiting;
-      // * Whether this vertex is fully connected
-      std::vector<bool> connected;
+            // All of u's edges have been followed.
+            path.pop_back();
+            if( low[ u ] == index[ u ] ) {
+              // u's component is everything above it on the stack.
+              typename std::vector<vertex_descriptor>::iterator first = component.end();
+              do {
+                --first;
+                on_stack[ *first ] = false;
+              } while( *first != u );
+              if( 1 < component.end() - first )
+                cycles.push_back( std::vector<vertex_descriptor>( first, component.end() ) );
+              component.erase( first, component.end() );
+            }
+
+            if( path.empty() )
+              break;
+            vertex_descriptor p = path.back().first;
+            low[ p ] = std::min( low[ p ], low[ u ] );
+            v = p;
+          }
+        }
+      }
+
+      // Found but neither run nor failed
+      bool stuck( vertex_descriptor v ) const {
+        return HAS_OUT_EDGES == ( state[ v ].flags & ( HAS_OUT_EDGES | CONNECTED | FAILED ) );
+      }
+
+      // The input has ended.  Vertices that were only ever mentioned as
+      // targets will never be run so they don't hold anything up.
+      void release_implicit() {
+        resize_properties();
+        for( vertex_descriptor v = 0; v < state.size(); ++v )
+          if( not has_out_edges( v ) )
+            mark_connected( v );
+      }
   };
 
   template< class Graph >
@@ -62,22 +253,12 @@ namespace boost {
     {
     public:
       typedef typename graph_traits< Graph >::vertex_descriptor vertex_descriptor;
-      typedef typename graph_traits< Graph >::out_edge_iterator out_edge_iterator;
-      typedef typename graph_traits< Graph >::in_edge_iterator  in_edge_iterator;
 
-      vertex_iterator() : g(NULL), end(true) {}
+      vertex_iterator() : g(NULL), end(true), released(false) {}
 
-      explicit vertex_iterator( StreamDfs< Graph > &_g ) : g(&_g), end( false ) {
+      explicit vertex_iterator( StreamDfs< Graph > &_g ) : g(&_g), end( false ), released( false ) {
         tie( iter, enditer ) = vertices( static_cast<Graph&>(*g) );
-        if( iter == enditer )
-          end = true;
-        else
-          replenish_q();
-
-        if( not q.empty() ) {
-          current = q.front();
-          q.pop();
-        }
+        increment();
       }
 
     private:
@@ -90,78 +271,48 @@ namespace boost {
           return current == other.current;
       }
 
+      // Visiting a vertex is what connects it.  Anything that was only
+      // waiting on it goes into the graph's ready queue.
       void increment() {
         replenish_q();
-        current = q.front();
-        q.pop();
-        return;
+        if( end )
+          return;
+        current = g->ready.front();
+        g->ready.pop();
+        g->mark_connected( current );
       }
 
       void replenish_q() {
-        while( q.empty() ) {
-          // Defer to the base class iterator to find a new vertex
-          if( iter == enditer ) {
-            // TODO Need to find implicit vertices and insert them into the
-            // queue
-            end = true;
-            return;
-          }
-
-          // Since we deferred to the base iterator the graph could have grown.
-          // The property map needs to grow with it.
-          g->resize_properties();
-
-          if( g->hasoutedges[ *iter ] )
+        while( g->ready.empty() ) {
+          // Defer to the base class iterator to find a new vertex for which
+          // all out edges are known.
+          if( iter != enditer ) {
+            g->found_vertex( *iter );
             ++iter;
-
-          // The base iterator found a vertex for which all out edges are known.
-          g->hasoutedges[ *iter ] = true;
-
-          // Find the number of adjacent edges that are still not marked as
-          // connected.  Assign this to the waiting property for this vertex.
-          std::pair< // I really want the auto keyword.
-              out_edge_iterator,
-              out_edge_iterator
-            > edges = out_edges( *iter, *g );
-          for( ; edges.first != edges.second; ++edges.first ) {
-            if( not g->connected[ target( *edges.first, *g ) ] )
-              ++g->waiting[ *iter ];
+            continue;
           }
 
-          mark_connected( *iter );
-        }
-      }
-
-      void mark_connected( vertex_descriptor v ) {
-        // TODO Review this and get the properties attached to the graph.
-        if( 0 == g->waiting[ v ] and not g->connected[ v ] ) {
-          // Mark it connected and queue it up.
-          g->connected[ v ] = true;
-          q.push( v );
-
-          // Traverse through in edges to see what else has become connected.
-          std::pair< // I really want the auto keyword.
-              in_edge_iterator,
-              in_edge_iterator
-            > edges = in_edges( v, *g );
-          for( ; edges.first != edges.second; ++edges.first ) {
-            vertex_descriptor u = source( *edges.first, *g );
-            if( g->hasoutedges[ u ] ) {
-              --g->waiting[ u ];
-              mark_connected( u );
-            }
+          // Vertices that the base iterator never got to, like those only
+          // ever named as targets, are taken with the edges they have.
+          if( released ) {
+            end = true;
+            return;
           }
+          released = true;
+          g->resize_properties();
+          for( vertex_descriptor v = 0; v < g->state.size(); ++v )
+            g->found_vertex( v );
         }
       }
 
       // These data members keep track of where we are in the base class's
       // iterator.
       typename graph_traits< Graph >::vertex_iterator iter,enditer;
-      std::queue<vertex_descriptor>                   q;
 
       StreamDfs< Graph >                             *g;
       vertex_descriptor                               current;
       bool                                            end;
+      bool                                            released;
 
       friend class iterator_core_access;
     };
@@ -0,0 +1,177 @@
+/*
+ * © Copyright 2011 Carl N. Baldwin
+ *
+ * Confidential computer software. Valid license from Carl Baldwin required for
+ * possession, use or copying.
+ */
+#ifndef STREAM_MATCHER_H
+#define STREAM_MATCHER_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <libxml/tree.h>
+
+/*
+ * This class matches elements against the path-like subset of XPath that
+ * makes sense on a stream.  That is, a union of location paths made up of
+ * child ('/') and descendant ('//') steps with simple name tests or '*':
+ *
+ *   /path/to/element
+ *   //element
+ *   //element|/path/to/elem
+ *
+ * The expression is compiled into a small non-deterministic automaton.  The
+ * parser reports each start tag with push() and each end tag with pop().  The
+ * set of active states for each open element is kept on a stack so that each
+ * element is tested exactly once no matter how big the document grows.
+ *
+ * compile() returns false for anything outside of this subset (predicates,
+ * axes, functions, namespace prefixes, etc.).  The caller is expected to fall
+ * back to evaluating the full expression in that case.
+ */
+class stream_matcher {
+  public:
+    stream_matcher() : num_open( 0 ) {}
+
+    bool compile( const char *expression ) {
+      paths.clear();
+      paths.push_back( path_t() );
+
+      const char *p = expression;
+      skip_space( p );
+      while( *p ) {
+        path_t &path = paths.back();
+
+        step_t step;
+        step.descendant = false;
+        if( '/' == *p ) {
+          ++p;
+          if( '/' == *p ) {
+            step.descendant = true;
+            ++p;
+          }
+        } else if( not path.empty() ) {
+          return false;
+        }
+
+        if( '*' == *p ) {
+          ++p;
+        } else {
+          const char *b = p;
+          while( is_name_char( *p ) )
+            ++p;
+          if( b == p or not is_name_start( *b ) )
+            return false;
+          step.name.assign( b, p );
+        }
+        path.push_back( step );
+
+        skip_space( p );
+        if( '|' == *p ) {
+          ++p;
+          skip_space( p );
+          if( not *p ) return false;
+          paths.push_back( path_t() );
+        } else if( *p and '/' != *p ) {
+          return false;
+        }
+      }
+
+      for( std::vector<path_t>::const_iterator i = paths.begin(); i != paths.end(); ++i )
+        if( i->empty() )
+          return false;
+
+      // The document node is the only thing open to start with.
+      states.clear();
+      states.push_back( state_set() );
+      for( size_t i = 0; i < paths.size(); ++i )
+        states.back().push_back( std::make_pair( i, 0 ) );
+      num_open = 1;
+      return true;
+    }
+
+    /*
+     * Called for each start tag.  Returns true if the element matches the
+     * expression.
+     */
+    bool push( const xmlChar *name, const xmlChar *uri ) {
+      if( num_open == states.size() )
+        states.push_back( state_set() );
+
+      const state_set &current = states[ num_open-1 ];
+      state_set       &next    = states[ num_open ];
+      next.clear();
+
+      bool matched = false;
+      for( state_set::const_iterator i = current.begin(); i != current.end(); ++i ) {
+        const path_t &path = paths[ i->first ];
+        const step_t &step = path[ i->second ];
+
+        if( step.descendant )
+          add_state( next, *i );
+
+        if( step.matches( name, uri ) ) {
+          if( i->second + 1 == path.size() )
+            matched = true;
+          else
+            add_state( next, std::make_pair( i->first, i->second + 1 ) );
+        }
+      }
+
+      ++num_open;
+      return matched;
+    }
+
+    /*
+     * Called for each end tag.
+     */
+    void pop() {
+      if( 1 < num_open )
+        --num_open;
+    }
+
+  private:
+    struct step_t {
+      bool        descendant;
+      std::string name;  // Empty matches any element
+
+      bool matches( const xmlChar *elem, const xmlChar *uri ) const {
+        if( name.empty() ) return true;
+        // An unprefixed name test only matches elements in no namespace.
+        if( uri ) return false;
+        return not strcmp( name.c_str(), reinterpret_cast<const char*>( elem ) );
+      }
+    };
+
+    typedef std::vector<step_t>                     path_t;
+    typedef std::vector< std::pair<size_t,size_t> > state_set;
+
+    static void add_state( state_set &set, const std::pair<size_t,size_t> &state ) {
+      for( state_set::const_iterator i = set.begin(); i != set.end(); ++i )
+        if( *i == state ) return;
+      set.push_back( state );
+    }
+
+    static void skip_space( const char *&p ) {
+      while( ' ' == *p or '\t' == *p or '\n' == *p )
+        ++p;
+    }
+
+    static bool is_name_start( char c ) {
+      return ( 'a' <= c and c <= 'z' ) or ( 'A' <= c and c <= 'Z' ) or '_' == c
+          or ( c & 0x80 );
+    }
+
+    static bool is_name_char( char c ) {
+      return is_name_start( c ) or ( '0' <= c and c <= '9' ) or '-' == c or '.' == c;
+    }
+
+    std::vector<path_t>    paths;
+    // One set of active states for each open element.  This is only ever
+    // grown so the sets keep their storage as elements come and go.
+    std::vector<state_set> states;
+    size_t                 num_open;
+};
+
+#endif
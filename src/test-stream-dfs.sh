@@ -0,0 +1,9 @@
+#!/bin/bash
+
+echo; echo
+
+echo "Checking graphs far deeper than the stack..."
+./bench-stream-dfs 100000 || exit 1
+
+echo "Checking fifo and critical path scheduling..."
+./bench-schedule 100 8 || exit 1
@@ -14,6 +14,10 @@ echo "Checking bogus arg..."
 xmlargs -bogus //name path.sh 2>/dev/null
 if [ $? -ne 1 ]; then exit 1; fi
 
+echo "Checking bad xpath expression..."
+xmlargs '//name[' echo < /dev/null 2>/dev/null
+if [ $? -ne 1 ]; then exit 1; fi
+
 echo "Checking non-existant script..."
 cat $srcdir/data/tiny.xml | xmlargs //name pathhh.sh 2>/dev/null
 if [ $? -ne 127 ]; then exit 1; fi
@@ -26,6 +30,10 @@ echo "Checking failed script"
 cat $srcdir/data/tiny.xml | xmlargs //name false 2>/dev/null
 if [ $? -ne 123 ]; then exit 1; fi
 
+echo "Checking failed script with maxprocs = 2"
+cat $srcdir/data/tiny.xml | xmlargs -n 1 -P 2 //name false 2>/dev/null
+if [ $? -ne 123 ]; then exit 1; fi
+
 set -e
 
 echo "Checking missing command arg..."
@@ -49,6 +57,16 @@ diff -u results/xmlargs3 $srcdir/data/golden/xmlargs3
 cat $srcdir/data/small.xml | xmlargs -St -n 3 '/*/*/name' echo > results/xmlargs4
 diff -u results/xmlargs4 $srcdir/data/golden/xmlargs4
 
+echo "Checking -M"
+cat $srcdir/data/small.xml | xmlargs -M -n 3 '/*/*/name' echo > results/xmlargs4
+diff -u results/xmlargs4 $srcdir/data/golden/xmlargs4
+test "7" = $(xmlargs -f $srcdir/data/xmlargs-missed-one -M -n 1 '//block/log/commit/message' | wc -l)
+
+echo "Checking -B"
+cat $srcdir/data/small.xml | xmlargs -S -B 7 -n 3 '/*/*/name' echo > results/xmlargs4
+diff -u results/xmlargs4 $srcdir/data/golden/xmlargs4
+xmlargs -B 0 //name < /dev/null 2>/dev/null && exit 1
+
 echo "Checking -W"
 test 'schematic-data' != "$(cat $srcdir/data/small.xml | xmlargs -S '/blocks/block[ name = "c" ]/*/files/*/file[ contains( ., "schematic-" ) ]')"
 test 'schematic-data'  = "$(xmlargs -f "$srcdir/data/small.xml"  -W '/blocks/block[ name = "c" ]/*/files/*/file[ contains( ., "schematic-" ) ]')"
@@ -56,3 +74,38 @@ test 'schematic-data'  = "$(xmlargs -f "$srcdir/data/small.xml"  -W '/blocks/blo
 echo "Checking that all matching nodes get found"
 test "7" = $(xmlargs -f $srcdir/data/xmlargs-missed-one -W -n 1 '//block/log/commit/message' | wc -l)
 test "7" = $(xmlargs -f $srcdir/data/xmlargs-missed-one -S -n 1 '//block/log/commit/message' | wc -l)
+
+echo "Checking -S with a union of paths"
+test "Tue, 03 Oct 2006 14:51:53 -0600 a b c d e f g i j k h" = "$(xmlargs -S -f $srcdir/data/small.xml '/blocks/started|//block/name')"
+
+echo "Checking -P with --keep-order"
+cat $srcdir/data/small.xml | xmlargs -S -n 3 -P 4 --keep-order '/*/*/name' -- sh -c 'echo "$@"' sh > results/xmlargs4
+diff -u results/xmlargs4 $srcdir/data/golden/xmlargs4
+
+echo "Checking that text is passed unescaped"
+test 'a&b <c> d' = "$(echo '<r><x>a&amp;b <![CDATA[<c>]]> d</x></r>' | xmlargs -S //x)"
+test 'a&b <c> d' = "$(echo '<r><x>a&amp;b <![CDATA[<c>]]> d</x></r>' | xmlargs -W //x)"
+
+echo "Checking --descendant-text"
+test 'ac' = "$(echo '<r><x>a<y>b</y>c</x></r>' | xmlargs //x)"
+test 'abcd' = "$(echo '<r><x>a<y>b<z>c</z></y>d</x></r>' | xmlargs -S --descendant-text //x)"
+
+echo "Checking -0, --delim and --json-lines"
+test "a:a:b:b:c:" = "$(xmlargs -0 -f $srcdir/data/small.xml '/*/*/name' | tr '\0' : | cut -c1-10)"
+test "a;a;b;b;c;" = "$(xmlargs -n 2 --delim ';' -f $srcdir/data/small.xml '/*/*/name' | cut -c1-10)"
+test '["a","a"]' = "$(xmlargs -n 2 --json-lines -f $srcdir/data/small.xml '/*/*/name' | head -1)"
+test '["q\"\\\t"]' = "$(printf '<r><x>q"\\\t</x></r>' | xmlargs --json-lines //x)"
+xmlargs -0 //x cat < /dev/null 2>/dev/null && exit 1
+test 123 = "$(xmlargs -f $srcdir/data/small.xml '/*/*/name' > /dev/full 2>/dev/null; echo $?)"
+
+echo "Checking --documents"
+docs='<?xml version="1.0"?>\n<a><n>1</n></a>\n<?xml version="1.0"?>\n<a><n>2</n><!-- </a> --></a><a x="/>"><n>3</n><![CDATA[</a>]]></a>'
+test "1 2 3" = "$(printf "$docs" | xmlargs --documents root --parse-threads 3 //n)"
+test "1 2 3" = "$(printf "$docs" | xmlargs --documents root --parse-threads 1 -n 1 //n | xargs)"
+test "1 2 3" = "$(printf "$docs" | xmlargs --documents root --unordered-documents -n 1 //n | sort | xargs)"
+test "1 2" = "$(printf '<a><n>1</n></a>\0<a><n>2</n></a>\0' | xmlargs --documents nul //n)"
+test "1 2" = "$(printf '<a><n>1</n></a>\n--\n<a><n>2</n></a>' | xmlargs --documents $'\n--\n' //n)"
+
+echo "Checking -s"
+test "5" = $(xmlargs -s 100 -f $srcdir/data/small.xml '/*/*/name' | wc -l)
+xmlargs --show-limits 2>&1 | grep -q "actually using"
@@ -27,13 +27,29 @@ cat $srcdir/data/tiny.xml | xmlforeach //block tiny.xml 2>/dev/null
 if [ $? -ne 126 ]; then exit 1; fi
 
 echo "Checking failed script"
+cat $srcdir/data/tiny.xml | xmlforeach //block --no-builtins false 2>/dev/null
+if [ $? -ne 123 ]; then exit 1; fi
+
+echo "Checking built-in false"
 cat $srcdir/data/tiny.xml | xmlforeach //block false 2>/dev/null
 if [ $? -ne 123 ]; then exit 1; fi
 
+echo "Checking built-in cat on a full disk"
+xmlforeach -f $srcdir/data/small.xml //block cat > /dev/full 2>/dev/null
+if [ $? -ne 123 ]; then exit 1; fi
+
 echo "Checking failed script with maxprocs = 2"
 xmlforeach -S -f $srcdir/data/tiny.xml  -t -P 2 //block false
 if [ $? -ne 123 ]; then exit 1; fi
 
+echo "Checking failed record with --persistent"
+cat $srcdir/data/tiny.xml | PERSIST_FAIL=block2 xmlforeach --persistent //block persist.sh > /dev/null
+if [ $? -ne 123 ]; then exit 1; fi
+
+echo "Checking non-existant script with --persistent"
+cat $srcdir/data/tiny.xml | xmlforeach --persistent //block pathhh.sh 2>/dev/null
+if [ $? -ne 127 ]; then exit 1; fi
+
 set -e
 
 echo "Checking the simplest xml file..."
@@ -44,3 +60,64 @@ cat $srcdir/data/failed | xmlforeach -S //block -- true
 
 echo "Output is correct? ..."
 diff -u results/tiny.path $srcdir/data/golden/tiny.path
+
+echo "Checking -M..."
+cat $srcdir/data/tiny.xml | xmlforeach -M //block path.sh > results/tiny.path
+diff -u results/tiny.path $srcdir/data/golden/tiny.path
+
+echo "Checking --persistent..."
+test "block1 block2" = "$(xmlforeach -f $srcdir/data/tiny.xml --persistent //block persist.sh | xargs)"
+test "block1 block2" = "$(xmlforeach -f $srcdir/data/tiny.xml --persistent -P 2 //block persist.sh | sort | xargs)"
+
+echo "Checking built-in commands..."
+for cmd in cat true "printenv name XMLELEMENT XMLTEXT"; do
+  xmlforeach -R -f $srcdir/data/small.xml //block -- $cmd > results/builtin
+  xmlforeach -R -f $srcdir/data/small.xml --no-builtins //block -- $cmd > results/nobuiltin
+  diff -u results/nobuiltin results/builtin
+done
+test "block1" = "$(xmlforeach -f $srcdir/data/tiny.xml //block printenv name nosuchvar | head -1)"
+
+echo "Checking --documents..."
+test "<n>1</n><n>2</n>" = "$(printf '<a><n>1</n></a><a><n>2</n></a>' | xmlforeach --documents root --parse-threads 2 //n cat)"
+
+echo "Checking --split..."
+rm -rf results/split; mkdir -p results/split
+xmlforeach -f $srcdir/data/small.xml --split 'results/split/$name.xml' //block
+test "a b c d e f g h i j k" = "$(ls results/split | sed 's/.xml$//' | xargs)"
+test "$(xmlforeach -f $srcdir/data/small.xml '//block[name = "c"]' cat; echo)" = "$(cat results/split/c.xml)"
+xmlforeach -f $srcdir/data/small.xml --split 'results/split/part-${XMLSHARD}' --shards 3 //block
+test "11" = $(cat results/split/part-* | grep -c '^<block>')
+test "4 4 3" = "$(grep -c '^<block>' results/split/part-0 results/split/part-1 results/split/part-2 | cut -d: -f2 | xargs)"
+if xmlforeach --split x --shards 0 //block < /dev/null 2>/dev/null; then exit 1; fi
+if xmlforeach --split x //block cat < /dev/null 2>/dev/null; then exit 1; fi
+if echo '<r><b><n>..</n></b></r>' | xmlforeach --split 'results/split/$n' //b 2>/dev/null; then exit 1; fi
+if echo '<r><b><n/></b></r>' | xmlforeach --split 'results/split/$n' //b 2>/dev/null; then exit 1; fi
+if echo '<r><b/></r>' | xmlforeach --split 'results/split/$n' //b 2>/dev/null; then exit 1; fi
+rm -f results/split/x
+if echo '<r><b><n>x</n></b><b/></r>' | xmlforeach --split 'results/split/$n' //b 2>/dev/null; then exit 1; fi
+test '<b><n>x</n></b>' = "$(cat results/split/x)"
+if xmlforeach -f $srcdir/data/small.xml --split /dev/full //block 2>/dev/null; then exit 1; fi
+
+echo "Checking --journal and --resume..."
+rm -f results/journal results/ran
+if xmlforeach --journal results/journal -f $srcdir/data/small.xml //block -- sh -c 'echo $name >> results/ran; test "$name" != e'; then exit 1; fi
+test 11 = $(wc -l < results/journal)
+test 1 = $(grep -c "	1	" results/journal)
+xmlforeach --resume results/journal -f $srcdir/data/small.xml //block -- sh -c 'echo $name > results/ran'
+test e = "$(cat results/ran)"
+test 12 = $(wc -l < results/journal)
+xmlforeach --journal results/journal --key name -f $srcdir/data/small.xml //block true
+test "a b c" = "$(tail -11 results/journal | cut -f1 | head -3 | xargs)"
+test -z "$(xmlforeach --resume results/journal --key name -f $srcdir/data/small.xml //block printenv name)"
+if xmlforeach --key name //block true < /dev/null 2>/dev/null; then exit 1; fi
+( echo '<r>'; for i in $(seq 1 100); do echo "<e><n>$i</n></e>"; done; echo '</r>' ) > results/e100.xml
+for key in "" "--key n"; do
+  rm -f results/journal
+  if xmlforeach --journal results/journal $key -f results/e100.xml //e -- sh -c 'test $n -le 70'; then exit 1; fi
+  test 100 = $(wc -l < results/journal)
+  test "$(seq 71 100)" = "$(xmlforeach --resume results/journal $key -f results/e100.xml //e printenv n | sort -n)"
+done
+rm -f results/journal
+echo '<r><b/></r>' | xmlforeach --journal results/journal //b true
+test 2 = $(echo '<r><b/><b/><b/></r>' | xmlforeach --resume results/journal //b echo ran | wc -l)
+test 3 = $(cut -f1 results/journal | sort -u | wc -l)
@@ -32,13 +32,56 @@ if [ $? -ne 123 ]; then exit 1; fi
 test -s errors.xml
 xmllint --noout errors.xml
 
+echo "Checking that expressions only see the element itself..."
+echo '<r xmlns:p="urn:x"><p:b><name>a</name><child><name>c</name></child></p:b><p:b><name>c</name></p:b></r>' |
+  xmltsort '//*[name]' '/*/name' '/*/child/name' -- cat > results/nested.xml 2>results/nested.err || exit 1
+grep -q "Ignoring another element named 'c'" results/nested.err || exit 1
+test "<child><name>c</name></child><p:b xmlns:p=\"urn:x\"><name>a</name><child><name>c</name></child></p:b>" = "$(cat results/nested.xml)" || exit 1
+
+echo "Checking critical path scheduling..."
+cat > results/chains.xml <<EOF
+<r>
+<b><name>short</name><cost>4</cost></b>
+<b><name>long1</name><cost>1</cost><child><name>long2</name></child></b>
+<b><name>long2</name><cost>1</cost><child><name>long3</name></child></b>
+<b><name>long3</name><cost>5</cost></b>
+</r>
+EOF
+test "short long3 long2 long1" = "$(xmltsort -f results/chains.xml //b name child/name -- printenv name | xargs)" || exit 1
+test "long3 long2 short long1" = "$(xmltsort --critical-path -f results/chains.xml //b name child/name -- printenv name | xargs)" || exit 1
+test "long3 short long2 long1" = "$(xmltsort --cost cost -f results/chains.xml //b name child/name -- printenv name | xargs)" || exit 1
+
+echo "Checking a long chain..."
+( echo '<r>'
+  for i in $(seq 1 300); do echo "<b><name>n$i</name><child><name>n$((i + 1))</name></child></b>"; done
+  echo '<b><name>n301</name></b></r>' ) > results/chain.xml
+xmltsort -S -f results/chain.xml //b name child/name -- printenv name > results/chain.out || exit 1
+test "$(seq 301 -1 1 | sed 's/^/n/')" = "$(cat results/chain.out)" || exit 1
+
+echo "Checking --journal and --resume..."
+rm -f results/tsort.journal
+xmltsort --journal results/tsort.journal --key name -f $srcdir/data/small.xml //block /block/name /block/hierarchy/child/name -- sh -c 'test "$name" != g'
+if [ $? -ne 123 ]; then exit 1; fi
+test "b c d h i j k" = "$(grep '	0	' results/tsort.journal | cut -f1 | sort | xargs)" || exit 1
+test "g f e a" = "$(xmltsort --resume results/tsort.journal --key name -f $srcdir/data/small.xml //block /block/name /block/hierarchy/child/name -- printenv name | xargs)" || exit 1
+test -z "$(xmltsort --resume results/tsort.journal --key name -f $srcdir/data/small.xml //block /block/name /block/hierarchy/child/name -- printenv name)" || exit 1
+
+echo "Checking that what depends on a failure is skipped"
+xmltsort -S -f $srcdir/data/small.xml -E results/errors.xml //block /block/name /block/hierarchy/child/name -- sh -c 'test "$name" != c'
+if [ $? -ne 123 ]; then exit 1; fi
+xmllint --noout results/errors.xml || exit 1
+test "a b c" = "$(xmllint --xpath '/*/block/name/text()' results/errors.xml | fold -w1 | sort | xargs)" || exit 1
+
 echo "Checking failed script with maxprocs = 2"
 cat $srcdir/data/tiny.xml | xmltsort -StP 2 //block /block/name /block/hierarchy/child/name false
 if [ $? -ne 123 ]; then exit 1; fi
 
 echo "Checking failed script with cycle"
-cat $srcdir/data/small-cycle.xml | xmltsort -S //block /*/name /*/hierarchy/child/name true
+cat $srcdir/data/small-cycle.xml | xmltsort -S -E results/cycle.xml //block /*/name /*/hierarchy/child/name true 2>results/cycle.err
 if [ $? -ne 122 ]; then exit 1; fi
+test "e f g i" = "$(grep 'Found a cycle' results/cycle.err | grep -o "'[a-z]*'" | tr -d "'" | sort | xargs)" || exit 1
+xmllint --noout results/cycle.xml || exit 1
+test "a e f g i" = "$(xmllint --xpath '/*/block/name/text()' results/cycle.xml | fold -w1 | sort | xargs)" || exit 1
 
 set -e
 
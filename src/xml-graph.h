@@ -7,15 +7,18 @@
 #ifndef XMLGRAPH_H
 #define XMLGRAPH_H
 
+#include <string>
+
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/properties.hpp>
 
 /*
- * These two boiler plate types attach an xmlDocPtr to each vertex in the graph
- * below.
+ * These two boiler plate types attach the serialized text of its xml element
+ * to each vertex in the graph below.  Bytes take far less room than a tree
+ * while the vertex waits to be run.
  */
-struct docptr_t { typedef boost::vertex_property_tag kind; };
-typedef boost::property<docptr_t,xmlDocPtr> docptr_p;
+struct payload_t { typedef boost::vertex_property_tag kind; };
+typedef boost::property<payload_t,std::string> payload_p;
 
 /*
  * This class uses the BGL's adjacency_list class to create a basic graph type
@@ -34,7 +37,7 @@ typedef boost::adjacency_list<
     // Directionality is bidirectionalS because this algorithm will have the
     // need to follow edges backwards often.
     boost::bidirectionalS,
-    docptr_p
+    payload_p
   > XmlGraph_base;
 
   template< class Graph >
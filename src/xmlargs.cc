@@ -5,9 +5,13 @@
  * possession, use or copying.
  */
 #include <unistd.h>
+#include <getopt.h>
+#include <poll.h>
 
+#include <deque>
 #include <vector>
 #include <iterator>
+#include <set>
 #include <string>
 #include <fstream>
 #include <cstring>
@@ -26,130 +30,418 @@ class basic_xmlargs : public basic_marcher<Ch, Tr> {
         ran( false ),
         max_chars(0), max_args(0),
         initial_length( 0 ),
-        args_length( 0 )
+        args_length( 0 ),
+        args_end( 0 ),
+        num_initial( 0 ),
+        keep_order( false ),
+        descendant_text( false ),
+        format( OUTPUT_LINES )
       {
         while( *argv )
-          initial_length += strlen( *argv++ ) + 1;
+          initial_length += arg_size( *argv++ );
+
+        for( const char **i = process_handler::get_argv(); *i; ++i, ++num_initial )
+          cmd_args.push_back( *i );
       }
 
     virtual ~basic_xmlargs() { /* Nothing to do here. */ }
 
     void finish() {
-      if( ( not ran and run_if_empty ) or 0 != arguments.size() )
+      if( ( not ran and run_if_empty ) or 0 != offsets.size() )
         handle_arguments();
+
+      while( not outputs.empty() )
+        pump_outputs( true );
+
+      // Fail the way echo would have.
+      parent::out.flush();
+      if( parent::output_failed() )
+        process_handler::handle_exit_status( 1 );
     }
 
     void set_max_chars( int max ) {
       max_chars = max;
     }
 
+    /*
+     * The space one argument takes from the exec limit: the string, its
+     * terminator and the pointer to it in argv.
+     */
+    static int arg_size( const char *arg ) {
+      return strlen( arg ) + 1 + sizeof( char* );
+    }
+
     void set_max_args( int max ) {
       max_args = max;
     }
 
+    /*
+     * Take the text of all descendants of each element instead of only its
+     * own text children.
+     */
+    void set_descendant_text( bool on ) {
+      descendant_text = on;
+    }
+
+    /*
+     * These choose how the arguments are written when the command is just
+     * echo.  By default each batch is written on one line separated by
+     * spaces.  With a delimiter each argument is followed by it instead,
+     * and with JSON lines each batch is written as an array of strings.
+     */
+    void set_delimiter( const std::string &delim ) {
+      format    = OUTPUT_DELIMITED;
+      delimiter = delim;
+    }
+
+    void set_json_lines() {
+      format = OUTPUT_JSON;
+    }
+
     void set_run_if_empty( bool on ) {
       run_if_empty = on;
     }
 
+    /*
+     * When running more than one command at a time, capture the standard
+     * output of each and write it out in the order the commands were
+     * started.
+     */
+    void set_keep_order( bool on ) {
+      keep_order = on;
+    }
+
+  protected:
+    void chunk_handled() {
+      parent::chunk_handled();
+      if( not outputs.empty() )
+        pump_outputs( false );
+    }
+
   private:
     pid_t handle_arguments() {
       ran = true;
-      // This vector will build all of the arguments.
-      std::vector<const char*> cmd_args;
 
       if( not strcmp( "echo", process_handler::get_argv()[0] ) and not process_handler::get_argv()[1] ) {
         // If the command is just echo then don't spawn children.  Just do it.
-        int size = arguments.size();
-        if( 1 < size )
-          std::copy( arguments.begin(), arguments.end()-1,
-                     std::ostream_iterator<std::string>( std::cout, " " ) );
-        if( 0 < size )
-          std::cout << *(arguments.end()-1) <<  std::endl;
-        arguments.clear();
-        args_length = 0;
+        write_arguments();
+        clear_arguments();
         return 0;
       }
 
-      // Start with the initial arguments.
-      const char **initial_args = process_handler::get_argv();
-      while( *initial_args )
-        cmd_args.push_back( *initial_args++ );
+      // Start with the initial arguments and point the rest into the arena.
+      // The arena doesn't move until clear_arguments() so the pointers stay
+      // good until the command has been started.
+      cmd_args.resize( num_initial );
+      for( std::vector<size_t>::const_iterator i = offsets.begin(); i != offsets.end(); ++i )
+        cmd_args.push_back( &arena[ *i ] );
+      cmd_args.push_back( NULL );
+
+      pid_t pid;
+      if( keep_order )
+        pid = spawn_ordered( &cmd_args[0] );
+      else
+        pid = process_handler::spawn_program( &cmd_args[0] );
 
-      std::vector<std::string>::const_iterator i;
-      for( i = arguments.begin(); i != arguments.end(); ++i )
-        cmd_args.push_back( const_cast<char*>( i->c_str() ) );
+      // The parent doesn't need the arguments list anymore.
+      clear_arguments();
+      return pid;
+    }
 
-      cmd_args.push_back( NULL );
+    /*
+     * Writes the collected arguments in the chosen format.  They stay in the
+     * sink's buffer until it fills or finish() flushes it.
+     */
+    void write_arguments() {
+      output_sink &out = parent::out;
+      size_t size = offsets.size();
+      switch( format ) {
+        case OUTPUT_LINES :
+          if( 0 == size )
+            break;
+          for( size_t i = 0; i < size; ++i ) {
+            if( i )
+              out.put( ' ' );
+            out.write( &arena[ offsets[i] ], argument_length( i ) );
+          }
+          out.put( '\n' );
+          break;
 
-      if( pid_t pid = process_handler::spawn_worker() ) {
-        // The parent doesn't need the arguments list anymore.
-        arguments.clear();
-        args_length = 0;
-        return pid;
+        case OUTPUT_DELIMITED :
+          for( size_t i = 0; i < size; ++i ) {
+            out.write( &arena[ offsets[i] ], argument_length( i ) );
+            out.write( delimiter.data(), delimiter.size() );
+          }
+          break;
+
+        case OUTPUT_JSON :
+          if( 0 == size )
+            break;
+          out.put( '[' );
+          for( size_t i = 0; i < size; ++i ) {
+            if( i )
+              out.put( ',' );
+            write_json_string( &arena[ offsets[i] ], argument_length( i ) );
+          }
+          out.write( "]\n", 2 );
+          break;
       }
+    }
 
-      exec_program( cmd_args );
+    size_t argument_length( size_t i ) const {
+      size_t end = i + 1 < offsets.size() ? offsets[ i+1 ] : args_end;
+      return end - offsets[i] - 1;
     }
 
-    void exec_program( std::vector<const char*> &arg_vector ) {
-      if( process_handler::verbose() ) {
-        const char **args = &arg_vector[0];
-        while( *args ) {
-          if( args != &arg_vector[0] ) std::cerr << ' ';
-          std::cerr << *args;
-          ++args;
+    void write_json_string( const char *str, size_t len ) {
+      static const char hex[] = "0123456789abcdef";
+      output_sink &out = parent::out;
+
+      out.put( '"' );
+      const char *plain = str;
+      for( const char *c = str; c != str + len; ++c ) {
+        unsigned char ch = *c;
+        if( '"' != ch and '\\' != ch and 0x20 <= ch )
+          continue;
+
+        out.write( plain, c - plain );
+        plain = c + 1;
+        out.put( '\\' );
+        switch( ch ) {
+          case '"'  : out.put( '"' );  break;
+          case '\\' : out.put( '\\' ); break;
+          case '\n' : out.put( 'n' );  break;
+          case '\r' : out.put( 'r' );  break;
+          case '\t' : out.put( 't' );  break;
+          default :
+            out.write( "u00", 3 );
+            out.put( hex[ ch >> 4 ] );
+            out.put( hex[ ch & 0xf ] );
         }
-        std::cerr << std::endl;
       }
+      out.write( plain, str + len - plain );
+      out.put( '"' );
+    }
 
-      execvp( arg_vector[0], const_cast<char**>(&arg_vector[0]) );
+    /*
+     * Drops the arguments that have been handed off.  Anything appended to
+     * the arena after the last of them (an argument still being collected)
+     * is moved down to the front.
+     */
+    void clear_arguments() {
+      arena.erase( arena.begin(), arena.begin() + args_end );
+      offsets.clear();
+      args_end = 0;
+      args_length = 0;
+    }
 
-      // This section will only be reached if the exec failed
-      switch( errno ) {
-        case ENOENT : exit( 127 );
-        default     : exit( 126 );
+    /*
+     * The captured output of one command.  The output of the oldest one is
+     * passed through as soon as it arrives.  Later ones are held until
+     * everything before them is done.
+     */
+    struct batch_output {
+      pid_t       pid;
+      int         fd;
+      std::string data;
+    };
+
+    pid_t spawn_ordered( const char **argv ) {
+      // A child can't finish while its output isn't being read so keep
+      // reading while waiting for a free slot.
+      while( not this->slot_available() )
+        pump_outputs( true );
+
+      int fd[2];
+      if( pipe2( fd, O_CLOEXEC ) ) {
+        this->errno_msg( "pipe" );
+        this->abort();
       }
+
+      pid_t pid = this->spawn_program( argv, -1, -1, NULL, fd[1] );
+      close( fd[1] );
+
+      outputs.push_back( batch_output() );
+      outputs.back().pid = pid;
+      outputs.back().fd  = fd[0];
+      return pid;
     }
 
-    void handle_node( xmlNodePtr node ) {
-      std::string current_arg;
+    void pump_outputs( bool block ) {
+      std::vector<struct pollfd> fds;
+      std::vector<batch_output*> polled;
+      for( typename std::deque<batch_output>::iterator i = outputs.begin(); i != outputs.end(); ++i )
+        if( -1 != i->fd ) {
+          struct pollfd pfd = { i->fd, POLLIN, 0 };
+          fds.push_back( pfd );
+          polled.push_back( &*i );
+        }
+
+      if( fds.empty() ) {
+        if( block and not this->slot_available() )
+          this->reap_process();
+      } else if( 0 < poll( &fds[0], fds.size(), block ? ( exiting.empty() ? -1 : 10 ) : 0 ) ) {
+        char buf[ 64 * 1024 ];
+        for( size_t i = 0; i < fds.size(); ++i ) {
+          if( not fds[i].revents )
+            continue;
+
+          batch_output &out = *polled[i];
+          ssize_t num = read( out.fd, buf, sizeof( buf ) );
+          if( 0 < num ) {
+            out.data.append( buf, num );
+          } else if( 0 == num or EINTR != errno ) {
+            // The command closed its output so it is about to exit.
+            // It is reaped once it has without waiting for it here.
+            close( out.fd );
+            out.fd = -1;
+            exiting.insert( out.pid );
+          }
+        }
+      }
+
+      if( not exiting.empty() )
+        this->reap_finished();
+
+      while( not outputs.empty() ) {
+        batch_output &out = outputs.front();
+        parent::write_all( 1, toXmlChar( out.data.c_str() ), out.data.size() );
+        out.data.clear();
+        if( -1 != out.fd )
+          break;
+        outputs.pop_front();
+      }
+    }
 
-      // Get all of the text for the current node to current_arg
-      // Should this be doing text children of descendant nodes too?
-      for( xmlNodePtr child = node->children; child; child = child->next )
-        if( XML_TEXT_NODE == child->type )
-          current_arg += toChar( serialize_node( child ) );
+    void post_reap_process( std::pair<pid_t,int> child ) {
+      exiting.erase( child.first );
+    }
 
-      if( 0 < max_args and max_args == arguments.size() + 1 ) {
-        arguments.push_back( current_arg );
+    void handle_node( xmlNodePtr node ) {
+      // Append the text of the current node to the arena just as it is in
+      // the document.  Entities have already been replaced by the parser.
+      size_t start = arena.size();
+      if( descendant_text )
+        append_descendant_text( node );
+      else
+        for( xmlNodePtr child = node->children; child; child = child->next )
+          append_text( child );
+      arena.push_back( '\0' );
+
+      if( 0 < max_args and static_cast<size_t>( max_args ) == offsets.size() + 1 ) {
+        add_argument( start );
         handle_arguments();
       } else {
-        int current_length = current_arg.length() + 1;
+        int current_length = arena.size() - start + sizeof( char* );
 
-        if( max_chars < initial_length + args_length + current_length )
+        if( not offsets.empty() and
+            max_chars < initial_length + args_length + current_length ) {
           handle_arguments();
+          start = 0;
+        }
 
-        arguments.push_back( current_arg );
+        add_argument( start );
         args_length += current_length;
       }
     }
 
+    void append_text( xmlNodePtr node ) {
+      if( ( XML_TEXT_NODE == node->type or XML_CDATA_SECTION_NODE == node->type )
+          and node->content ) {
+        const char *text = toChar( node->content );
+        arena.insert( arena.end(), text, text + strlen( text ) );
+      }
+    }
+
+    /*
+     * Appends the text of every descendant in document order.
+     */
+    void append_descendant_text( xmlNodePtr node ) {
+      xmlNodePtr child = node->children;
+      while( child and child != node ) {
+        append_text( child );
+        if( XML_ELEMENT_NODE == child->type and child->children ) {
+          child = child->children;
+          continue;
+        }
+        while( child != node and not child->next )
+          child = child->parent;
+        if( child != node )
+          child = child->next;
+      }
+    }
+
+    void add_argument( size_t start ) {
+      offsets.push_back( start );
+      args_end = arena.size();
+    }
+
     basic_xmlargs();
     basic_xmlargs( const basic_xmlargs& );
 
     bool run_if_empty, ran;
     int max_chars, max_args;
     int initial_length, args_length;
-    std::vector<std::string> arguments;
+    // The collected arguments, each terminated by a NUL, and where each
+    // one starts.  Both are reused from one batch to the next.
+    std::vector<char> arena;
+    std::vector<size_t> offsets;
+    size_t args_end;
+    std::vector<const char*> cmd_args;
+    int num_initial;
+    bool keep_order;
+    bool descendant_text;
+
+    enum output_format {
+      OUTPUT_LINES,
+      OUTPUT_DELIMITED,
+      OUTPUT_JSON
+    };
+    output_format format;
+    std::string delimiter;
+    std::deque<batch_output> outputs;
+    // Commands that closed their output but haven't been reaped yet
+    std::set<pid_t> exiting;
 };
 
 typedef basic_xmlargs<char> xmlargs;
 using namespace std;
 
+extern char **environ;
+
+// Room left for the things exec needs that aren't counted otherwise.
+static const long arg_headroom = 2048;
+
+long environment_size() {
+  long size = sizeof( char* );
+  for( char **var = environ; *var; ++var )
+    size += xmlargs::arg_size( *var );
+  return size;
+}
+
+/*
+ * The most argument space that a command can actually use.  This is the
+ * system's limit less what the environment takes and a safety margin.
+ */
+long max_command_length() {
+  long arg_max = sysconf( _SC_ARG_MAX );
+  if( arg_max <= 0 )
+    arg_max = _POSIX_ARG_MAX;
+  return arg_max - environment_size() - arg_headroom;
+}
+
+void show_limits( long maxchars ) {
+  cerr << "Your environment variables take up " << environment_size() << " bytes" << endl;
+  cerr << "POSIX upper limit on argument length (this system): " << sysconf( _SC_ARG_MAX ) << endl;
+  cerr << "POSIX smallest allowable upper limit on argument length (all systems): " << _POSIX_ARG_MAX << endl;
+  cerr << "Maximum length of command we could actually use: " << max_command_length() << endl;
+  cerr << "Size of command buffer we are actually using: " << maxchars << endl;
+}
+
 void usage( const char *name ) {
   cerr << endl;
   cerr << "Usage:" << endl;
-  cerr << "  " << name << " [-f <file>] [-W|-S] [-v|-t] [-r] [-n <maxargs>] <xpath expression> <cmd> [arg [...]]" << std::endl;
+  cerr << "  " << name << " [-f <file>] [-W|-S|-M] [-B <bytes>] [--documents root|nul|<delim> [--parse-threads <n>] [--unordered-documents]] [-v|-t] [-r] [-n <maxargs>] [-s <maxchars>] [--show-limits] [--descendant-text] [-0|--delim <string>|--json-lines] [-P <maxprocs> [--keep-order]] <xpath expression> <cmd> [arg [...]]" << std::endl;
 }
 
 int main( int argc, char *argv[] ) {
@@ -159,9 +451,22 @@ int main( int argc, char *argv[] ) {
   // Defaults
   bool verbose = false;
   int  maxargs = 0;
-  int  maxchars = 20 * 1024; // Is there a system #define for this?
+  long maxchars = max_command_length();
+  bool showlimits = false;
   bool run_if_empty = true;
+  int  maxprocs = 1;
+  bool keep_order = false;
+  bool descendant_text = false;
+  bool delimited = false;
+  std::string delimiter;
+  bool json_lines = false;
   bool wholefile = true;
+  int  chunksize = 0;
+  bool boundedmem = false;
+  bool multidoc = false;
+  std::string docdelim;
+  int  parsethreads = sysconf( _SC_NPROCESSORS_ONLN );
+  bool docorder = true;
 
   int c, bflg, aflg, errflg;
   char *ifile = NULL, *ofile = NULL;
@@ -174,8 +479,120 @@ int main( int argc, char *argv[] ) {
   while( myargc < argc and strcmp( "--", argv[ myargc ] ) )
     ++myargc;
 
-  while( ( c = getopt( myargc, argv, "f:rn:vtWS" ) ) != -1 )
+  // Long options that have no short equivalent
+  enum {
+    OPT_KEEP_ORDER = 256,
+    OPT_SHOW_LIMITS,
+    OPT_DESCENDANT_TEXT,
+    OPT_DELIM,
+    OPT_JSON_LINES,
+    OPT_DOCUMENTS,
+    OPT_PARSE_THREADS,
+    OPT_UNORDERED_DOCUMENTS
+  };
+  static const struct option longopts[] = {
+    { "keep-order",      no_argument, NULL, OPT_KEEP_ORDER },
+    { "show-limits",     no_argument, NULL, OPT_SHOW_LIMITS },
+    { "descendant-text", no_argument, NULL, OPT_DESCENDANT_TEXT },
+    { "delim",           required_argument, NULL, OPT_DELIM },
+    { "json-lines",      no_argument, NULL, OPT_JSON_LINES },
+    { "documents",           required_argument, NULL, OPT_DOCUMENTS },
+    { "parse-threads",       required_argument, NULL, OPT_PARSE_THREADS },
+    { "unordered-documents", no_argument,       NULL, OPT_UNORDERED_DOCUMENTS },
+    { NULL,              0,           NULL, 0 }
+  };
+
+  while( ( c = getopt_long( myargc, argv, "f:rn:s:vtWSMB:P:0", longopts, NULL ) ) != -1 )
     switch (c) {
+      case OPT_SHOW_LIMITS :
+        showlimits = true;
+        break;
+
+      case 's' :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": max-chars must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        maxchars = atol( optarg );
+        if( maxchars < 1 ) {
+          cerr << argv[0] << ": max-chars must be a number > 0" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        if( max_command_length() < maxchars ) {
+          cerr << argv[0] << ": max-chars reduced to " << max_command_length() << endl;
+          maxchars = max_command_length();
+        }
+        break;
+
+      case OPT_DOCUMENTS :
+        multidoc = true;
+        if( not strcmp( "root", optarg ) )
+          docdelim.clear();
+        else if( not strcmp( "nul", optarg ) )
+          docdelim.assign( 1, '\0' );
+        else
+          docdelim = optarg;
+        break;
+
+      case OPT_PARSE_THREADS :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": parse threads must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        parsethreads = atoi( optarg );
+        if( parsethreads < 1 ) {
+          cerr << argv[0] << ": parse threads must be a number > 0" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        break;
+
+      case OPT_UNORDERED_DOCUMENTS :
+        docorder = false;
+        break;
+
+      case OPT_KEEP_ORDER :
+        keep_order = true;
+        break;
+
+      case OPT_DESCENDANT_TEXT :
+        descendant_text = true;
+        break;
+
+      case '0' :
+        delimited = true;
+        delimiter.assign( 1, '\0' );
+        break;
+
+      case OPT_DELIM :
+        delimited = true;
+        delimiter = optarg;
+        break;
+
+      case OPT_JSON_LINES :
+        json_lines = true;
+        break;
+
+      case 'P' :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": maxprocs must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        if( not strcmp( "0", optarg ) ) {
+          cerr << argv[0] << ": maxprocs cannot be \"0\"" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        maxprocs = atoi( optarg );
+        break;
+
       case 't' : case 'v' :
         verbose = true;
         break;
@@ -192,10 +609,30 @@ int main( int argc, char *argv[] ) {
         wholefile = true;
         break;
 
+      case 'M' :
+        wholefile = false;
+        boundedmem = true;
+        break;
+
       case 'f' :
         ifile = optarg;
         break;
 
+      case 'B' :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": chunk size must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        chunksize = atoi( optarg );
+        if( chunksize < 1 ) {
+          cerr << argv[0] << ": chunk size must be a number > 0" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        break;
+
       case 'n' :
         for( const char *digit = optarg; *digit; ++digit )
           if( *digit < '0' or '9' < *digit ) {
@@ -211,6 +648,12 @@ int main( int argc, char *argv[] ) {
         exit(1);
     }
 
+  if( showlimits ) {
+    show_limits( maxchars );
+    if( argc == optind )
+      exit(0);
+  }
+
   if( ( argc - optind ) < 1 ) {
     cerr << argv[0] << ": Not enough arguments" << endl;
     usage( argv[0] );
@@ -226,28 +669,55 @@ int main( int argc, char *argv[] ) {
     command_args = default_cmd;
   }
 
-  std::istream *in = &cin;
-  if( ifile ) {
-    in = new std::ifstream( ifile );
-    if( not in or not *in ) {
-      std::cerr << "Couldn't open file for reading!" << std::endl;
-      exit(1);
-    }
+  if( ( delimited or json_lines ) and
+      ( strcmp( "echo", command_args[0] ) or command_args[1] ) ) {
+    cerr << argv[0] << ": -0, --delim and --json-lines only apply without a command" << endl;
+    usage( argv[0] );
+    exit(1);
+  }
+  if( delimited and json_lines ) {
+    cerr << argv[0] << ": --json-lines can't be used with -0 or --delim" << endl;
+    usage( argv[0] );
+    exit(1);
   }
 
+  // The chunk reader asks the stream how much input is waiting which only
+  // works if cin is not tied to stdio.
+  std::ios::sync_with_stdio( false );
+
+  // A file is only opened as a stream if it can't be mapped.
+  std::ifstream file;
+  std::istream *in = ifile ? &file : &cin;
+
   xmlargs my_xmlargs( *in, argv[optind], command_args, wholefile );
   my_xmlargs.set_max_chars( maxchars );
   my_xmlargs.set_max_args( maxargs );
+  my_xmlargs.set_descendant_text( descendant_text );
+  if( delimited )
+    my_xmlargs.set_delimiter( delimiter );
+  if( json_lines )
+    my_xmlargs.set_json_lines();
   my_xmlargs.set_run_if_empty( run_if_empty );
   my_xmlargs.set_verbose( verbose );
+  my_xmlargs.set_max_procs( maxprocs );
+  my_xmlargs.set_keep_order( keep_order );
+  if( chunksize )
+    my_xmlargs.set_chunk_size( chunksize );
+  my_xmlargs.set_bounded_memory( boundedmem );
+  if( multidoc )
+    my_xmlargs.set_documents( docdelim, parsethreads, docorder );
+  if( ifile and not my_xmlargs.map_input( ifile ) ) {
+    file.open( ifile );
+    if( not file ) {
+      std::cerr << "Couldn't open file for reading!" << std::endl;
+      exit(1);
+    }
+  }
 
   my_xmlargs.run();
 
   my_xmlargs.finish();
 
-  if( ifile )
-    delete( in );
-
   if( my_xmlargs.process_failed() )
     exit(123);
 
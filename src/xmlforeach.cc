@@ -5,6 +5,7 @@
  * possession, use or copying.
  */
 #include <unistd.h>
+#include <getopt.h>
 #include <cstring>
 
 #include "crawl-with-fork.h"
@@ -14,7 +15,8 @@ using namespace std;
 void usage( const char *name ) {
   cerr << endl;
   cerr << "Usage:" << endl;
-  cerr << "  " << name << " [-f <file>] [-W|-S] [-R] [-v|-t] [-P <maxprocs>] <xpath expression> <cmd> [arg [...]]" << std::endl;
+  cerr << "  " << name << " [-f <file>] [-W|-S|-M] [-B <bytes>] [--documents root|nul|<delim> [--parse-threads <n>] [--unordered-documents]] [-R] [-v|-t] [-P <maxprocs>] [--persistent] [--no-builtins] [--journal <file>] [--resume <file>] [--key <key expr>] <xpath expression> <cmd> [arg [...]]" << std::endl;
+  cerr << "  " << name << " [-f <file>] [-W|-S|-M] [-B <bytes>] [--documents root|nul|<delim> [--parse-threads <n>] [--unordered-documents]] [-v|-t] --split <template> [--shards <n>] <xpath expression>" << std::endl;
 }
 
 int main( int argc, const char *argv[] ) {
@@ -25,8 +27,21 @@ int main( int argc, const char *argv[] ) {
   bool verbose = false;
   bool printroot = false;
   bool wholefile = true;
+  int  chunksize = 0;
+  bool boundedmem = false;
+  bool multidoc = false;
+  std::string docdelim;
+  int  parsethreads = sysconf( _SC_NPROCESSORS_ONLN );
+  bool docorder = true;
   int  maxprocs = 1;
   int  stop_on_error = false;
+  bool persistent = false;
+  bool builtins = true;
+  const char *split = NULL;
+  int  shards = 0;
+  const char *journalfile = NULL;
+  const char *resumefile = NULL;
+  const char *keyexpr = NULL;
 
   int c, bflg, aflg, errflg;
   char *ifile = NULL, *ofile = NULL;
@@ -39,8 +54,103 @@ int main( int argc, const char *argv[] ) {
   while( myargc < argc and strcmp( "--", argv[ myargc ] ) )
     ++myargc;
 
-  while( ( c = getopt( myargc, const_cast<char**>(argv), "f:RvtP:WS" ) ) != -1 )
+  // Long options that have no short equivalent
+  enum {
+    OPT_PERSISTENT = 256,
+    OPT_NO_BUILTINS,
+    OPT_SPLIT,
+    OPT_SHARDS,
+    OPT_DOCUMENTS,
+    OPT_PARSE_THREADS,
+    OPT_UNORDERED_DOCUMENTS,
+    OPT_JOURNAL,
+    OPT_RESUME,
+    OPT_KEY
+  };
+  static const struct option longopts[] = {
+    { "persistent",  no_argument,       NULL, OPT_PERSISTENT },
+    { "no-builtins", no_argument,       NULL, OPT_NO_BUILTINS },
+    { "split",       required_argument, NULL, OPT_SPLIT },
+    { "shards",      required_argument, NULL, OPT_SHARDS },
+    { "documents",           required_argument, NULL, OPT_DOCUMENTS },
+    { "parse-threads",       required_argument, NULL, OPT_PARSE_THREADS },
+    { "unordered-documents", no_argument,       NULL, OPT_UNORDERED_DOCUMENTS },
+    { "journal",     required_argument, NULL, OPT_JOURNAL },
+    { "resume",      required_argument, NULL, OPT_RESUME },
+    { "key",         required_argument, NULL, OPT_KEY },
+    { NULL,          0,                 NULL, 0 }
+  };
+
+  while( ( c = getopt_long( myargc, const_cast<char**>(argv), "f:RvtP:WSMB:", longopts, NULL ) ) != -1 )
     switch (c) {
+      case OPT_DOCUMENTS :
+        multidoc = true;
+        if( not strcmp( "root", optarg ) )
+          docdelim.clear();
+        else if( not strcmp( "nul", optarg ) )
+          docdelim.assign( 1, '\0' );
+        else
+          docdelim = optarg;
+        break;
+
+      case OPT_PARSE_THREADS :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": parse threads must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        parsethreads = atoi( optarg );
+        if( parsethreads < 1 ) {
+          cerr << argv[0] << ": parse threads must be a number > 0" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        break;
+
+      case OPT_UNORDERED_DOCUMENTS :
+        docorder = false;
+        break;
+
+      case OPT_JOURNAL :
+        journalfile = optarg;
+        break;
+
+      case OPT_RESUME :
+        resumefile = optarg;
+        break;
+
+      case OPT_KEY :
+        keyexpr = optarg;
+        break;
+
+      case OPT_PERSISTENT :
+        persistent = true;
+        break;
+
+      case OPT_NO_BUILTINS :
+        builtins = false;
+        break;
+
+      case OPT_SPLIT :
+        split = optarg;
+        break;
+
+      case OPT_SHARDS :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": shards must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        shards = atoi( optarg );
+        if( shards < 1 ) {
+          cerr << argv[0] << ": shards must be a number > 0" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        break;
+
       case 'R' :
         printroot = true;
         break;
@@ -57,10 +167,30 @@ int main( int argc, const char *argv[] ) {
         wholefile = true;
         break;
 
+      case 'M' :
+        wholefile = false;
+        boundedmem = true;
+        break;
+
       case 'f' :
         ifile = optarg;
         break;
 
+      case 'B' :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": chunk size must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        chunksize = atoi( optarg );
+        if( chunksize < 1 ) {
+          cerr << argv[0] << ": chunk size must be a number > 0" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        break;
+
       case 'P' :
         for( const char *digit = optarg; *digit; ++digit )
           if( *digit < '0' or '9' < *digit ) {
@@ -81,31 +211,86 @@ int main( int argc, const char *argv[] ) {
         exit(1);
     }
 
-  if( ( argc - optind ) < 2 ) {
+  if( ( argc - optind ) < ( split ? 1 : 2 ) ) {
     cerr << argv[0] << ": Not enough arguments" << endl;
     usage( argv[0] );
     exit(1);
   }
 
-  std::istream *in = &cin;
-  if( ifile ) {
-    in = new std::ifstream( ifile );
-    if( not in or not *in ) {
-      std::cerr << "Couldn't open file for reading!" << std::endl;
-      exit(1);
-    }
+  if( split and ( argc - optind ) > 1 ) {
+    cerr << argv[0] << ": --split doesn't take a command" << endl;
+    usage( argv[0] );
+    exit(1);
+  }
+
+  if( shards and not split ) {
+    cerr << argv[0] << ": --shards only works with --split" << endl;
+    usage( argv[0] );
+    exit(1);
   }
 
-  marcher my_marcher( *in, argv[optind], argv + optind + 1, wholefile );
+  if( keyexpr and not journalfile and not resumefile ) {
+    cerr << argv[0] << ": --key only works with --journal or --resume" << endl;
+    usage( argv[0] );
+    exit(1);
+  }
+
+  if( ( journalfile or resumefile ) and ( split or persistent ) ) {
+    cerr << argv[0] << ": --journal and --resume don't work with --split or --persistent" << endl;
+    usage( argv[0] );
+    exit(1);
+  }
+
+  // When splitting no command is run but the process handler still wants
+  // one.  Writing elements to files is what cat would do.
+  const char *split_cmd[2];
+  split_cmd[0] = "cat";
+  split_cmd[1] = NULL;
+
+  const char **command_args = argv + optind + 1;
+  if( split )
+    command_args = split_cmd;
+
+  // The chunk reader asks the stream how much input is waiting which only
+  // works if cin is not tied to stdio.
+  std::ios::sync_with_stdio( false );
+
+  // A file is only opened as a stream if it can't be mapped.
+  std::ifstream file;
+  std::istream *in = ifile ? &file : &cin;
+
+  marcher my_marcher( *in, argv[optind], command_args, wholefile );
   my_marcher.set_stop_on_error( stop_on_error );
   my_marcher.set_max_procs( maxprocs );
   my_marcher.set_verbose( verbose );
+  if( chunksize )
+    my_marcher.set_chunk_size( chunksize );
+  my_marcher.set_bounded_memory( boundedmem );
+  if( multidoc )
+    my_marcher.set_documents( docdelim, parsethreads, docorder );
+  if( ifile and not my_marcher.map_input( ifile ) ) {
+    file.open( ifile );
+    if( not file ) {
+      std::cerr << "Couldn't open file for reading!" << std::endl;
+      exit(1);
+    }
+  }
   my_marcher.set_printroot( printroot );
+  my_marcher.set_persistent( persistent );
+  my_marcher.set_builtins( builtins );
+  if( split )
+    my_marcher.set_split( split, shards );
 
-  my_marcher.run();
+  // A resumed run goes on adding to the journal it resumes from.
+  run_journal journal;
+  if( resumefile )
+    journal.load( resumefile );
+  if( journalfile or resumefile ) {
+    journal.open( journalfile ? journalfile : resumefile );
+    my_marcher.set_journal( &journal, keyexpr );
+  }
 
-  if( ifile )
-    delete( in );
+  my_marcher.run();
 
   if( my_marcher.process_failed() )
     exit(123);
@@ -4,6 +4,7 @@
  * Confidential computer software. Valid license from Carl Baldwin required for
  * possession, use or copying.
  */
+#include <getopt.h>
 #include <unistd.h>
 #include <map>
 #include <cstring>
@@ -11,6 +12,8 @@
 #include "crawl-with-fork.h"
 #include "xml-graph.h"
 #include "stream-dfs.h"
+#include "name-table.h"
+#include "ready-queue.h"
 
 // Assumptions:
 //
@@ -18,7 +21,7 @@
 //    vertex expression.
 
 template<class Ch, class Tr = std::char_traits<Ch> >
-class basic_tsorter : public basic_marcher<Ch, Tr>, public strmQueueInterface<XmlGraph> {
+class basic_tsorter : public basic_marcher<Ch, Tr> {
   public:
     typedef basic_marcher<Ch,Tr>           parent;
     typedef boost::StreamDfs< XmlGraph >   graph_t;
@@ -34,163 +37,333 @@ class basic_tsorter : public basic_marcher<Ch, Tr>, public strmQueueInterface<Xm
       : parent( instream, expression, argv, allatonce ),
         _srcexpr( srcexpr ),
         _targetexpr( targetexpr ),
-        _errorstream( errorstream )
+        _errorstream( errorstream ),
+        _xpathCtx( xmlXPathNewContext( NULL ) ),
+        _scratch( xmlNewDoc( toXmlChar( "1.0" ) ) ),
+        _costcomp( NULL ),
+        _ready( _graph ),
+        _finished( false ),
+        _errors_started( false ),
+        _cycle_found( false )
       {
-        _graph.strm_q = this;
+        _graph.strm_q = NULL;
+        assert( _xpathCtx );
+
+        _srccomp    = compile( _srcexpr );
+        _targetcomp = compile( _targetexpr );
       }
 
+    virtual ~basic_tsorter() {
+      xmlXPathFreeCompExpr( _srccomp );
+      xmlXPathFreeCompExpr( _targetcomp );
+      if( _costcomp )
+        xmlXPathFreeCompExpr( _costcomp );
+      xmlXPathFreeContext(  _xpathCtx );
+      xmlFreeDoc( _scratch );
+    }
+
+    /*
+     * Reads the whole input, running the command for each vertex as soon as
+     * all of the vertices it depends on have been run successfully, and then
+     * waits for everything that can still run.
+     */
     void run() {
-      // Where's my 'auto'???
-      std::pair<
-          g_traits::vertex_iterator,
-          g_traits::vertex_iterator
-        > iters = boost::vertices( _graph );
-      while( iters.first != iters.second ) {
-        xmlDocPtr doc = boost::get( boost::get( docptr_t(), _graph ), *iters.first );
-        dumpNode( xmlDocGetRootElement( doc ), std::cout );
-        ++iters.first;
-      }
+      parent::run();
+      finish();
     }
 
-    bool empty() {
-      replenish_q();
-      return q.empty();
+    /*
+     * Runs the ready vertex with the most expensive chain of dependents
+     * waiting on it first instead of the one that was ready first.  The cost
+     * of a vertex is the number found with the expression or 1 without one.
+     */
+    void set_critical_path( bool on, const char *costexpr = NULL ) {
+      _ready.set_critical_path( on );
+      if( costexpr )
+        _costcomp = compile( costexpr );
     }
 
-    graph_t::vertex_descriptor &front() {
-      replenish_q();
-      return q.front();
+    // True if some vertices could never be run because they depend on
+    // themselves.
+    bool cycle_found() {
+      return _cycle_found;
     }
 
-    void pop() { q.pop(); }
+  protected:
+    void chunk_handled() {
+      parent::chunk_handled();
+      process_handler::reap_finished();
+      start_ready( false );
+    }
 
-    void replenish_q() {
-      while( not basic_marcher<Ch,Tr>::finished() and q.empty() )
-        basic_marcher<Ch,Tr>::read_chunk();
+    void finish() {
+      if( _finished )
+        return;
+      _finished = true;
+
+      // Anything named only as a child that never showed up has nothing to
+      // run so it is as good as done.
+      _graph.release_implicit();
+      start_ready( true );
+
+      // Whatever hasn't been run or failed by now is part of a cycle or
+      // depends on one.  The cycles are named and then they fail along with
+      // everything that depends on them.
+      std::vector< std::vector<g_traits::vertex_descriptor> > cycles;
+      _graph.find_cycles( cycles );
+      for( std::size_t c = 0; c < cycles.size(); ++c ) {
+        _cycle_found = true;
+        std::cerr << "Found a cycle between";
+        for( std::size_t i = 0; i < cycles[ c ].size(); ++i )
+          std::cerr << " '" << vertex_name( cycles[ c ][ i ] ) << "'";
+        std::cerr << std::endl;
+
+        for( std::size_t i = 0; i < cycles[ c ].size(); ++i )
+          _graph.mark_failed( cycles[ c ][ i ] );
+        report_failed();
+      }
+
+      if( _errors_started )
+        *_errorstream << "</" << parent::rootname << ">" << std::flush;
+      if( process_handler::journal() )
+        process_handler::journal()->sync();
     }
 
   private:
-    void post_reap_child( std::pair<pid_t,int> child ) {
-    //   pid_t cpid = child.first;
-    //   int status = child.second;
+    static xmlXPathCompExprPtr compile( const char *expression ) {
+      xmlXPathCompExprPtr comp = xmlXPathCompile( toXmlChar( expression ) );
+      if( not comp ) {
+        std::cerr << "Invalid XPath expression '" << expression << "'" << std::endl;
+        exit(1);
+      }
+      return comp;
+    }
 
-    //   if( pid_to_node.count( cpid ) ) {
-    //     Agnode_t *node = pid_to_node.find( cpid )->second;
-    //     pid_to_node.erase( cpid );
+    /*
+     * Starts ready vertices while there are free slots.  With wait this
+     * keeps going, waiting for children as needed, until nothing is running
+     * and nothing more is ready.
+     */
+    void start_ready( bool wait ) {
+      while( true ) {
+        g_traits::vertex_descriptor v;
+        while( process_handler::slot_available() and _ready.next( v ) )
+          run_vertex( v );
+
+        if( not wait or not process_handler::processes_are_active() )
+          break;
+        process_handler::reap_process();
+      }
+    }
 
-    //     bool failed = stream_tsort::finished_node( node, status );
+    // The element is parsed again from its bytes just long enough to start
+    // the command.  One that the journal says already succeeded is done.
+    void run_vertex( g_traits::vertex_descriptor v ) {
+      std::string &payload = boost::get( boost::get( payload_t(), _graph ), v );
+      xmlDocPtr doc = xmlReadMemory( payload.data(), payload.size(), NULL, NULL, 0 );
+      if( not doc ) {
+        std::cerr << "Couldn't parse an element again to run it" << std::endl;
+        _graph.mark_failed( v );
+        report_failed();
+        return;
+      }
 
-    //     if( not failed and node_to_xml.count( node ) ) {
-    //       xmlFreeDoc( node_to_xml[ node ] );
-    //       node_to_xml.erase( node );
-    //     }
-    //   }
-    }
+      xmlNodePtr root = xmlDocGetRootElement( doc );
+      std::string key;
+      if( process_handler::journal() ) {
+        key = parent::node_key( root );
+        if( process_handler::journal()->succeeded( key ) ) {
+          xmlFreeDoc( doc );
+          free_vertex( v );
+          _graph.mark_connected( v );
+          return;
+        }
+      }
 
-    // void handle_failed_node( Agnode_t *gnode, bool failed ) {
-    //   if( node_to_xml.count( gnode ) ) {
-    //     xmlDocPtr xdoc = node_to_xml[ gnode ];
-    //     if( _errorstream )
-    //       dumpNode( xmlDocGetRootElement( xdoc ), *_errorstream );
+      pid_t pid = parent::handle_node_fork( root );
+      xmlFreeDoc( doc );
+      process_handler::journal_job( pid, key );
+      _pid_to_vertex[ pid ] = v;
+    }
 
-    //     xmlFreeDoc( xdoc );
-    //     node_to_xml.erase( gnode );
-    //   }
-    // }
+    void post_reap_process( std::pair<pid_t,int> child ) {
+      typename std::map<pid_t, g_traits::vertex_descriptor>::iterator i = _pid_to_vertex.find( child.first );
+      if( i == _pid_to_vertex.end() )
+        return;
+      g_traits::vertex_descriptor v = i->second;
+      _pid_to_vertex.erase( i );
 
-    // void handle_node( Agnode_t *node ) {
-    //   pid_t child = parent::handle_node_fork( xmlDocGetRootElement( node_to_xml[ node ] ) );
-    //   pid_to_node.insert( std::make_pair( child, node ) );
-    // }
+      if( 0 == child.second ) {
+        free_vertex( v );
+        _graph.mark_connected( v );
+      } else {
+        _graph.mark_failed( v );
+        report_failed();
+      }
+    }
 
-    void finish() {
-    //   // stream_tsort::find_missing();
-    //   while( process_handler::children_active() ) {
-    //     process_handler::reap_all_active();
-    //     stream_tsort::flush_ready();
-    //   }
-    //   if( _errorstream )
-    //     *_errorstream << "<" << parent::rootname << ">" << std::flush;
-    //   stream_tsort::finished_graph();
-    //   if( _errorstream )
-    //     *_errorstream << "</" << parent::rootname << ">" << std::flush;
+    /*
+     * Writes the vertices that just failed, and those that can't be run
+     * because of them, to the error stream.
+     */
+    void report_failed() {
+      for( std::size_t i = 0; i < _graph.newly_failed.size(); ++i ) {
+        g_traits::vertex_descriptor v = _graph.newly_failed[ i ];
+        const std::string &payload = boost::get( boost::get( payload_t(), _graph ), v );
+        if( not payload.empty() and _errorstream ) {
+          if( not _errors_started ) {
+            *_errorstream << "<" << parent::rootname << ">";
+            _errors_started = true;
+          }
+          *_errorstream << payload << std::flush;
+        }
+        free_vertex( v );
+      }
+      _graph.newly_failed.clear();
     }
 
-    g_traits::vertex_descriptor getVertex( const char *name ) {
-      // I want the 'auto' keyword so bad
-      std::map<
-          std::string,
-          g_traits::vertex_descriptor
-        >::const_iterator i = _name_to_vertex.find( name );
+    void free_vertex( g_traits::vertex_descriptor v ) {
+      std::string().swap( boost::get( boost::get( payload_t(), _graph ), v ) );
+    }
 
-      if( i == _name_to_vertex.end() ) {
-        g_traits::vertex_descriptor vertex;
+    // Finds or creates the vertex for a name with just one lookup.
+    g_traits::vertex_descriptor getVertex( const xmlChar *name ) {
+      bool   added;
+      size_t index;
+      g_traits::vertex_descriptor &vertex
+        = _name_to_vertex.intern( name ? toChar( name ) : "", added, index );
+      if( added ) {
         vertex = boost::add_vertex( _graph );
-        _name_to_vertex.insert( std::make_pair( std::string( name ), vertex ) );
-        return vertex;
-      } else {
-        return _name_to_vertex[ name ];
+        if( _vertex_to_name.size() <= vertex )
+          _vertex_to_name.resize( vertex + 1, 0 );
+        _vertex_to_name[ vertex ] = index + 1;
       }
+      return vertex;
     }
 
-    void handle_node( xmlNodePtr node ) {
-      // Make this node into a new document.
-      xmlDocPtr doc = xmlNewDoc( toXmlChar( "1.0" ) );
-      xmlNodePtr copy = xmlDocCopyNode( node, doc, 1 );
-      assert( copy );
-      xmlDocSetRootElement( doc, copy );
+    std::string vertex_name( g_traits::vertex_descriptor v ) {
+      if( v < _vertex_to_name.size() and _vertex_to_name[ v ] )
+        return _name_to_vertex.name( _vertex_to_name[ v ] - 1 );
+      return std::string();
+    }
 
-      // Evaluate the XPath expressions
-      xmlXPathContextPtr xpathCtx = xmlXPathNewContext( doc );
-      assert( xpathCtx );
+    /*
+     * Namespaces declared above the node wouldn't be declared in its text.
+     * Only then is it copied into a document of its own, which declares
+     * them, before writing it out.
+     */
+    static void serialize( xmlNodePtr node, std::string &payload ) {
+      xmlDocPtr doc = NULL;
+      for( xmlNodePtr p = node->parent; p and XML_ELEMENT_NODE == p->type; p = p->parent )
+        if( p->nsDef ) {
+          doc = xmlNewDoc( toXmlChar( "1.0" ) );
+          node = xmlDocCopyNode( node, doc, 1 );
+          assert( node );
+          xmlDocSetRootElement( doc, node );
+          break;
+        }
+
+      xmlBufferPtr buf = xmlBufferCreate();
+      xmlNodeDump( buf, node->doc, node, 0, 0 );
+      payload.assign( toChar( xmlBufferContent( buf ) ), xmlBufferLength( buf ) );
+      xmlBufferFree( buf );
+      if( doc )
+        xmlFreeDoc( doc );
+    }
+
+    void handle_node( xmlNodePtr node ) {
+      // Evaluate the XPath expressions right where the node is.  So that "/"
+      // still means the node, as if it were the root of its own document,
+      // the node is made the only child of a scratch document for now.
+      // libxml2 walks simple expressions through the parent and sibling
+      // links so those have to be cut too, not just the document's.
+      // Relative expressions start at the node.
+      xmlNodePtr parent_node = node->parent, next = node->next, prev = node->prev;
+      node->parent = reinterpret_cast<xmlNodePtr>( _scratch );
+      node->next   = node->prev = NULL;
+      _scratch->children = _scratch->last = node;
+
+      _xpathCtx->doc  = _scratch;
+      _xpathCtx->node = node;
 
       // Find the name of the current node
-      xmlXPathObjectPtr srcXPathObj = xmlXPathEvalExpression( toXmlChar( _srcexpr ), xpathCtx );
+      xmlXPathObjectPtr srcXPathObj = xmlXPathCompiledEval( _srccomp, _xpathCtx );
       assert( srcXPathObj );
       xmlNodeSetPtr srcNodeSet = srcXPathObj->nodesetval;
+      g_traits::vertex_descriptor source;
+      bool duplicate = false;
       if( not srcNodeSet or 1 != srcNodeSet->nodeNr ) {
-        parent::handle_node_fork( xmlDocGetRootElement( doc ) );
-        xmlFreeDoc( doc );
+        // Without a name nothing can depend on it.  It can run right away.
+        source = boost::add_vertex( _graph );
       } else {
         xmlNodePtr *srcNode = srcNodeSet->nodeTab;
-        const char *srcname = toChar( xmlNodeGetContent( *srcNode ) );
-        // Agnode_t *src = stream_tsort::found_node( srcname );
+        xmlChar *srcname = xmlNodeGetContent( *srcNode );
         // Find or create the vertex representing this node
-        g_traits::vertex_descriptor source = getVertex( srcname );
-        // Attach the xml document to it.
-        boost::put( boost::get( docptr_t(), _graph ), source, doc );
-
-        // Find the target or child nodes
-        xmlXPathObjectPtr targetXPathObj = xmlXPathEvalExpression( toXmlChar( _targetexpr ), xpathCtx );
-        assert( targetXPathObj );
-        xmlNodeSetPtr targetNodes = targetXPathObj->nodesetval;
-
-        if( targetNodes )
-          for( xmlNodePtr *i = targetNodes->nodeTab; i != targetNodes->nodeTab + targetNodes->nodeNr; ++i ) {
-            const char *targetName = toChar( xmlNodeGetContent( *i ) );
-            g_traits::vertex_descriptor target = getVertex( targetName );
-            if( source != target )
-              boost::add_edge( source, target, _graph );
-          }
+        source = getVertex( srcname );
+
+        _graph.resize_properties();
+        if( _graph.has_out_edges( source ) ) {
+          std::cerr << "Ignoring another element named '" << ( srcname ? toChar( srcname ) : "" ) << "'" << std::endl;
+          duplicate = true;
+        } else {
+          // Find the target or child nodes
+          xmlXPathObjectPtr targetXPathObj = xmlXPathCompiledEval( _targetcomp, _xpathCtx );
+          assert( targetXPathObj );
+          xmlNodeSetPtr targetNodes = targetXPathObj->nodesetval;
+
+          if( targetNodes )
+            for( xmlNodePtr *i = targetNodes->nodeTab; i != targetNodes->nodeTab + targetNodes->nodeNr; ++i ) {
+              xmlChar *targetName = xmlNodeGetContent( *i );
+              g_traits::vertex_descriptor target = getVertex( targetName );
+              xmlFree( targetName );
+              if( source != target )
+                boost::add_edge( source, target, _graph );
+            }
+
+          xmlXPathFreeObject( targetXPathObj );
+        }
+        xmlFree( srcname );
+      }
+      xmlXPathFreeObject(  srcXPathObj );
 
-        q.push( source );
-        xmlXPathFreeObject( targetXPathObj );
+      double cost = 1;
+      if( _costcomp and not duplicate ) {
+        xmlXPathObjectPtr costXPathObj = xmlXPathCompiledEval( _costcomp, _xpathCtx );
+        if( costXPathObj ) {
+          double found = xmlXPathCastToNumber( costXPathObj );
+          if( found == found and 0 <= found )
+            cost = found;
+          xmlXPathFreeObject( costXPathObj );
+        }
       }
 
-      xmlXPathFreeObject(  srcXPathObj );
-      xmlXPathFreeContext( xpathCtx );
+      _scratch->children = _scratch->last = NULL;
+      node->parent = parent_node;
+      node->next   = next;
+      node->prev   = prev;
+
+      if( duplicate )
+        return;
+
+      // Keep the element as bytes until it is run.
+      serialize( node, boost::get( boost::get( payload_t(), _graph ), source ) );
+
+      _ready.found( source, cost );
+      _graph.found_vertex( source );
+      report_failed();
     }
 
     const char   *_srcexpr, *_targetexpr;
     std::ostream *_errorstream;
+    xmlXPathContextPtr  _xpathCtx;
+    xmlDocPtr           _scratch;
+    xmlXPathCompExprPtr _srccomp, _targetcomp, _costcomp;
     graph_t       _graph;
-    std::map<
-        std::string,
-        g_traits::vertex_descriptor
-      > _name_to_vertex;
-    Ch           *mybuf;
-    int           mybufsize;
-    std::queue<g_traits::vertex_descriptor> q;
+    ready_queue<graph_t> _ready;
+    name_table<g_traits::vertex_descriptor> _name_to_vertex;
+    std::vector<size_t> _vertex_to_name;   // One past the index in _name_to_vertex, 0 if none
+    std::map<pid_t, g_traits::vertex_descriptor> _pid_to_vertex;
+    bool          _finished, _errors_started, _cycle_found;
 
     basic_tsorter();
     basic_tsorter( const basic_tsorter& );
@@ -203,7 +376,7 @@ using namespace std;
 void usage( const char *name ) {
   cerr << endl;
   cerr << "Usage:" << endl;
-  cerr << "  " << name << " [-f <file>] [-W|-S] [-r] [-v|-t] [-P <maxprocs>] <xpath expression> <element name expr> <child name expr> <cmd> [arg [...]]" << std::endl;
+  cerr << "  " << name << " [-f <file>] [-W|-S|-M] [-B <bytes>] [-r] [-v|-t] [-P <maxprocs>] [--critical-path] [--cost <cost expr>] [--journal <file>] [--resume <file>] [--key <key expr>] <xpath expression> <element name expr> <child name expr> <cmd> [arg [...]]" << std::endl;
 }
 
 int main( int argc, const char *argv[] ) {
@@ -214,9 +387,16 @@ int main( int argc, const char *argv[] ) {
   bool verbose = false;
   bool printroot = false;
   bool wholefile = true;
+  int  chunksize = 0;
+  bool boundedmem = false;
   int  maxprocs = 1;
   int  stop_on_error = false;
   char *errorfile = NULL;
+  bool criticalpath = false;
+  const char *costexpr = NULL;
+  const char *journalfile = NULL;
+  const char *resumefile = NULL;
+  const char *keyexpr = NULL;
 
   int c, bflg, aflg, errflg;
   char *ifile = NULL, *ofile = NULL;
@@ -229,8 +409,46 @@ int main( int argc, const char *argv[] ) {
   while( myargc < argc and strcmp( "--", argv[ myargc ] ) )
     ++myargc;
 
-  while( ( c = getopt( argc, const_cast<char**>(argv), "f:E:RvtP:WS" ) ) != -1 )
+  enum {
+    OPT_CRITICAL_PATH = 256,
+    OPT_COST,
+    OPT_JOURNAL,
+    OPT_RESUME,
+    OPT_KEY
+  };
+
+  static const struct option longopts[] = {
+    { "critical-path", no_argument,       NULL, OPT_CRITICAL_PATH },
+    { "cost",          required_argument, NULL, OPT_COST },
+    { "journal",       required_argument, NULL, OPT_JOURNAL },
+    { "resume",        required_argument, NULL, OPT_RESUME },
+    { "key",           required_argument, NULL, OPT_KEY },
+    { NULL,            0,                 NULL, 0 }
+  };
+
+  while( ( c = getopt_long( myargc, const_cast<char**>(argv), "f:E:RvtP:WSMB:", longopts, NULL ) ) != -1 )
     switch (c) {
+      case OPT_JOURNAL :
+        journalfile = optarg;
+        break;
+
+      case OPT_RESUME :
+        resumefile = optarg;
+        break;
+
+      case OPT_KEY :
+        keyexpr = optarg;
+        break;
+
+      case OPT_CRITICAL_PATH :
+        criticalpath = true;
+        break;
+
+      case OPT_COST :
+        criticalpath = true;
+        costexpr = optarg;
+        break;
+
       case 'E' :
         errorfile = optarg;
         break;
@@ -247,10 +465,30 @@ int main( int argc, const char *argv[] ) {
         wholefile = true;
         break;
 
+      case 'M' :
+        wholefile = false;
+        boundedmem = true;
+        break;
+
       case 'f' :
         ifile = optarg;
         break;
 
+      case 'B' :
+        for( const char *digit = optarg; *digit; ++digit )
+          if( *digit < '0' or '9' < *digit ) {
+            cerr << argv[0] << ": chunk size must be a number > 0" << endl;
+            usage( argv[0] );
+            exit(1);
+          }
+        chunksize = atoi( optarg );
+        if( chunksize < 1 ) {
+          cerr << argv[0] << ": chunk size must be a number > 0" << endl;
+          usage( argv[0] );
+          exit(1);
+        }
+        break;
+
       case 't' : case 'v' :
         verbose = true;
         break;
@@ -281,19 +519,24 @@ int main( int argc, const char *argv[] ) {
     exit(1);
   }
 
+  if( keyexpr and not journalfile and not resumefile ) {
+    cerr << argv[0] << ": --key only works with --journal or --resume" << endl;
+    usage( argv[0] );
+    exit(1);
+  }
+
   std::ostream *errstream = NULL;
   if( errorfile ) {
     errstream = new ofstream( errorfile );
   }
 
-  std::istream *in = &cin;
-  if( ifile ) {
-    in = new std::ifstream( ifile );
-    if( not in or not *in ) {
-      std::cerr << "Couldn't open file for reading!" << std::endl;
-      exit(1);
-    }
-  }
+  // The chunk reader asks the stream how much input is waiting which only
+  // works if cin is not tied to stdio.
+  std::ios::sync_with_stdio( false );
+
+  // A file is only opened as a stream if it can't be mapped.
+  std::ifstream file;
+  std::istream *in = ifile ? &file : &cin;
 
   tsorter my_crawler( *in,
                        argv[optind],
@@ -304,14 +547,32 @@ int main( int argc, const char *argv[] ) {
                        errstream );
   my_crawler.set_stop_on_error( stop_on_error );
   my_crawler.set_max_procs( maxprocs );
+  if( criticalpath )
+    my_crawler.set_critical_path( true, costexpr );
+
+  // A resumed run goes on adding to the journal it resumes from.
+  run_journal journal;
+  if( resumefile )
+    journal.load( resumefile );
+  if( journalfile or resumefile ) {
+    journal.open( journalfile ? journalfile : resumefile );
+    my_crawler.set_journal( &journal, keyexpr );
+  }
   my_crawler.set_verbose( verbose );
+  if( chunksize )
+    my_crawler.set_chunk_size( chunksize );
+  my_crawler.set_bounded_memory( boundedmem );
+  if( ifile and not my_crawler.map_input( ifile ) ) {
+    file.open( ifile );
+    if( not file ) {
+      std::cerr << "Couldn't open file for reading!" << std::endl;
+      exit(1);
+    }
+  }
   my_crawler.set_printroot( printroot );
 
   my_crawler.run();
 
-  if( ifile )
-    delete( in );
-
   if( errstream ) {
     *errstream << flush;
     delete errstream;
@@ -320,8 +581,8 @@ int main( int argc, const char *argv[] ) {
   if( my_crawler.process_failed() )
     exit(123);
 
-  // if( my_crawler.cycle_found() )
-  //   exit(122);
+  if( my_crawler.cycle_found() )
+    exit(122);
 
   return 0;
 }
@@ -8,15 +8,23 @@
 #define XPATH_CRAWL_H
 
 #include <cassert>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <set>
-#include <stack>
+#include <vector>
 #include <libxml/parser.h>
+#include <libxml/SAX2.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
+#include <libxml/xmlreader.h>
 
 #include "xml-util.h"
+#include "stream-matcher.h"
+#include "mapped-file.h"
+#include "document-splitter.h"
+#include "document-pool.h"
 
 /*
  * This class extends the chunk parser and stuffs data from it into the libxml2
@@ -29,6 +37,25 @@
  * When the entire XML document has been seen and processed by 'handle_node'
  * this class calls the pure virtual finish() to signal that the XML document
  * has been processed and the derived class should finish its work.
+ *
+ * When streaming, path-like expressions are matched by a stream_matcher that
+ * is driven from the parser's start and end element callbacks.  Each element
+ * is tested once when it closes and is freed as soon as no open ancestor
+ * still needs it.  Any other expression falls back to evaluating the XPath
+ * expression over the partial document after each chunk.
+ *
+ * With set_bounded_memory() the same path-like expressions are matched from
+ * an xmlTextReader instead of the push parser.  Only matched elements are
+ * ever expanded into a tree so memory is bounded by the largest of them no
+ * matter how big or deep the rest of the document is.
+ *
+ * map_input() lets a regular file be parsed straight out of a memory mapping
+ * rather than being copied through the istream a chunk at a time.
+ *
+ * set_documents() is for input that holds many documents one after another.
+ * Each document is parsed whole, on a pool of threads, and the expression is
+ * evaluated against it there.  The matches are handed to handle_node() on
+ * this thread.
  */
 
 template<class Ch, class Tr = std::char_traits<Ch> >
@@ -38,33 +65,126 @@ class basic_xpath_stream {
       : in( _in ),
         bufsize( allatonce ? 8096 : 128 ),
         buf( new Ch[ bufsize+1 ] ),
+        adaptive( false ),
         initialized( false ),
         rootfound( false ),
         completed( false ),
         fileatonce( allatonce ),
         ctxt( NULL ),
         xpathExpr( expression ),
+        xpathComp( NULL ),
+        xpathCtx( NULL ),
+        streaming( false ),
+        num_pending( 0 ),
+        reader( NULL ),
+        use_reader( false ),
+        reader_next( false ),
+        map_pos( NULL ),
+        map_end( NULL ),
+        multi_document( false ),
+        parse_threads( 1 ),
+        document_order( true ),
         num_read(0)
     {
       LIBXML_TEST_VERSION
-      buf[bufsize+1] = '\0';
+      buf[bufsize] = '\0';
+
+      // Compile the expression once up front so that a bad expression is
+      // reported before any input is read.
+      xpathComp = xmlXPathCompile( toXmlChar( xpathExpr ) );
+      if( not xpathComp ) {
+        std::cerr << "Invalid XPath expression '" << xpathExpr << "'" << std::endl;
+        exit(1);
+      }
+
+      // What the fallback evaluation sees depends on where the chunks break so
+      // only the streaming matcher gets adaptive chunk sizes.
+      if( not fileatonce )
+        streaming = adaptive = matcher.compile( xpathExpr );
     }
 
     virtual ~basic_xpath_stream() {
-      delete buf;
+      delete [] buf;
+      if( reader )
+        xmlFreeTextReader( reader );
+      if( xpathCtx )
+        xmlXPathFreeContext( xpathCtx );
+      xmlXPathFreeCompExpr( xpathComp );
       xmlCleanupParser();
       if( rootfound )
         end_xml( rootname );
     }
 
     void run() {
-      while( not finished() and not not in )
+      if( multi_document ) {
+        read_documents();
+        return;
+      }
+
+      // The reader may still hold buffered input after the stream hits EOF.
+      while( not finished() and input_left() )
         read_chunk();
     }
 
     void read_chunk() {
-      in.read( buf, bufsize );
-      handle_chunk( buf, buf + in.gcount() );
+      if( use_reader )
+        read_elements();
+      else if( mapping.mapped() )
+        read_mapped();
+      else {
+        // Where chunks end only matters to the fallback evaluation.
+        std::streamsize num = read_input( buf, bufsize, adaptive );
+        handle_chunk( buf, buf + num );
+        adapt_chunk_size( num );
+      }
+
+      chunk_handled();
+    }
+
+    /*
+     * Match elements with an xmlTextReader rather than building the document
+     * with the push parser.  This only takes effect when streaming with an
+     * expression that the stream_matcher understands.
+     */
+    void set_bounded_memory( bool enabled ) {
+      use_reader = enabled and streaming;
+    }
+
+    /*
+     * Read the input from a memory mapping of the given file instead of from
+     * the stream.  Returns false, leaving the stream in use, if the file is
+     * not a regular file that can be mapped.
+     */
+    bool map_input( const char *path ) {
+      if( not mapping.map( path ) )
+        return false;
+      map_pos = reinterpret_cast<const Ch*>( mapping.begin() );
+      map_end = reinterpret_cast<const Ch*>( mapping.end() );
+      return true;
+    }
+
+    /*
+     * Use a fixed chunk size for reading the input.  This turns off the
+     * adaptive sizing that is otherwise used when streaming.
+     */
+    void set_chunk_size( int size ) {
+      adaptive = false;
+      resize_buf( size );
+      chunk_size_changed( bufsize );
+    }
+
+    /*
+     * Treat the input as a series of documents.  They are separated by the
+     * delimiter or, if it is empty, each one ends where its root element
+     * does.  Documents are parsed on the given number of threads.  Matches
+     * are handled in document order unless ordered is false, in which case
+     * each document is handled as soon as it has been parsed.
+     */
+    void set_documents( const std::string &delimiter, int threads, bool ordered ) {
+      multi_document = true;
+      splitter.set_delimiter( delimiter );
+      parse_threads  = threads;
+      document_order = ordered;
     }
 
     bool finished() { return completed; }
@@ -73,9 +193,16 @@ class basic_xpath_stream {
     virtual void handle_node( xmlNodePtr node ) = 0;
     virtual void begin_xml( const std::string & ) {}
     virtual void end_xml(   const std::string & ) {}
+    virtual void chunk_size_changed( int ) {}
+    // Called after each chunk of input so derived classes can catch up on
+    // other work between chunks.
+    virtual void chunk_handled() {}
+    // Called when reading from input_fd() might block.  Derived classes can
+    // get on with other work until it has something to read.
+    virtual void wait_for_input() {}
 
   protected:
-    void handle_chunk( Ch *b, Ch *e ) {
+    void handle_chunk( const Ch *b, const Ch *e ) {
       if( b == e ) return;
 
       if( not initialized ) {
@@ -95,6 +222,12 @@ class basic_xpath_stream {
         ctxt = xmlCreatePushParserCtxt( NULL, NULL, header, header_size, NULL );
         assert( ctxt );
 
+        if( streaming ) {
+          ctxt->_private = this;
+          ctxt->sax->startElementNs = start_element;
+          ctxt->sax->endElementNs   = end_element;
+        }
+
         xmlParseChunk( ctxt, b+num_in_header, e-(b+num_in_header), 0 );
       } else {
         if( not ctxt )
@@ -105,35 +238,35 @@ class basic_xpath_stream {
       if( XML_PARSER_EPILOG == ctxt->instate )
         completed = true;
 
-      if( not fileatonce or completed ) {
-        xmlXPathContextPtr xpathCtx = xmlXPathNewContext( ctxt->myDoc );
-        assert( xpathCtx );
+      if( not streaming and ( not fileatonce or completed ) ) {
+        // The context is reused for every chunk of this document.
+        if( not xpathCtx and ctxt->myDoc ) {
+          xpathCtx = xmlXPathNewContext( ctxt->myDoc );
+          assert( xpathCtx );
+        }
 
-        xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression( toXmlChar( xpathExpr ), xpathCtx );
+        xmlXPathObjectPtr xpathObj = NULL;
+        if( xpathCtx )
+          xpathObj = xmlXPathCompiledEval( xpathComp, xpathCtx );
 
         if( xpathObj ) {
           xmlNodeSetPtr nodes = xpathObj->nodesetval;
           if( nodes and nodes->nodeNr )
             for( xmlNodePtr *i = nodes->nodeTab; i != nodes->nodeTab + nodes->nodeNr; ++i )
-              if( nodeIsComplete( *i ) and not processed.count( *i ) ) {
-                processed.insert( *i );
-                unprocessed.erase( *i );
-                if( not rootfound ) {
-                  rootname = toChar( xmlDocGetRootElement( ctxt->myDoc )->name );
-                  begin_xml( rootname );
-                  rootfound = true;
-                }
-                handle_node( *i );
+              if( is_processed( *i ) ) {
+                continue;
+              } else if( nodeIsComplete( *i ) ) {
+                mark_node( *i, processed_mark );
+                dispatch_node( *i );
               } else {
-                unprocessed.insert( *i );
+                mark_node( *i, unprocessed_mark );
               }
 
           xmlXPathFreeObject(  xpathObj );
         }
-        xmlXPathFreeContext( xpathCtx );
       }
 
-      if( not fileatonce )
+      if( not fileatonce and not streaming )
         trim_nodes( xmlDocGetRootElement( ctxt->myDoc ) );
 
       if( completed ) {
@@ -143,6 +276,11 @@ class basic_xpath_stream {
         xmlFreeParserCtxt( ctxt );
         ctxt = NULL;
 
+        if( xpathCtx ) {
+          xmlXPathFreeContext( xpathCtx );
+          xpathCtx = NULL;
+        }
+
         if( not res )
           std::cerr << "Failed to parse " << std::endl;
 
@@ -153,6 +291,397 @@ class basic_xpath_stream {
     }
 
   protected:
+    bool input_left() {
+      if( use_reader )
+        return true;
+      if( mapping.mapped() )
+        return map_pos != map_end;
+      return not not in;
+    }
+
+    /*
+     * Hands the next piece of the mapping to the parser.  The data is never
+     * copied on this side.  The whole document is available at once so the
+     * streaming matcher gets the biggest chunks right away.
+     */
+    void read_mapped() {
+      // libxml2 takes the size of a document in memory as an int.  A bigger
+      // file goes through the push parser in chunks like a stream would.
+      if( fileatonce and mapping.size() <= INT_MAX ) {
+        read_mapped_document();
+        return;
+      }
+
+      std::ptrdiff_t num = adaptive ? max_adaptive_size : bufsize;
+      num = std::min( num, map_end - map_pos );
+      const Ch *b = map_pos;
+      map_pos += num;
+      handle_chunk( b, b + num );
+    }
+
+    void read_mapped_document() {
+      map_pos   = map_end;
+      completed = true;
+
+      xmlDocPtr doc = xmlReadMemory( mapping.begin(), mapping.size(), NULL, NULL, 0 );
+      if( not doc ) {
+        std::cerr << "Failed to parse " << std::endl;
+        finish();
+        return;
+      }
+
+      xpathCtx = xmlXPathNewContext( doc );
+      assert( xpathCtx );
+
+      xmlXPathObjectPtr xpathObj = xmlXPathCompiledEval( xpathComp, xpathCtx );
+      if( xpathObj ) {
+        xmlNodeSetPtr nodes = xpathObj->nodesetval;
+        if( nodes and nodes->nodeNr )
+          for( xmlNodePtr *i = nodes->nodeTab; i != nodes->nodeTab + nodes->nodeNr; ++i )
+            dispatch_node( *i );
+        xmlXPathFreeObject( xpathObj );
+      }
+
+      xmlXPathFreeContext( xpathCtx );
+      xpathCtx = NULL;
+      xmlFreeDoc( doc );
+
+      finish();
+    }
+
+    /*
+     * Multiple documents
+     */
+    void read_documents() {
+      document_pool pool( xpathExpr, parse_threads, document_order );
+
+      if( mapping.mapped() ) {
+        const char *b = mapping.begin();
+        const char *e = mapping.end();
+        while( b != e ) {
+          const char *doc_end = e;
+          const char *next = splitter.next( b, e, doc_end );
+          if( not next )
+            next = doc_end = e;
+          submit_document( pool, b, doc_end, false );
+          b = next;
+        }
+      } else {
+        // Documents are cut out of this buffer as soon as they are complete.
+        std::string pending;
+        size_t      chunk = max_adaptive_size;
+        while( in ) {
+          size_t size = pending.size();
+          pending.resize( size + chunk );
+          pending.resize( size + read_input( &pending[ size ], chunk, true ) );
+
+          const char *b = pending.data();
+          const char *e = b + pending.size();
+          const char *doc_end;
+          while( const char *next = splitter.next( b, e, doc_end ) ) {
+            submit_document( pool, b, doc_end, true );
+            b = next;
+          }
+          pending.erase( 0, b - pending.data() );
+        }
+        submit_document( pool, pending.data(), pending.data() + pending.size(), true );
+      }
+
+      while( pool.pending() )
+        handle_document( pool.take( true ) );
+
+      completed = true;
+      finish();
+    }
+
+    void submit_document( document_pool &pool, const char *b, const char *e, bool copy ) {
+      // Skip what's left between documents like a trailing newline.  An XML
+      // declaration has to be the very first thing in a document.
+      while( b != e and isspace( static_cast<unsigned char>( *b ) ) )
+        ++b;
+      if( b == e )
+        return;
+
+      while( document_pool::document *d = pool.take( pool.pending() >= pool.max_pending() ) )
+        handle_document( d );
+
+      document_pool::document *d = new document_pool::document;
+      if( copy ) {
+        d->data.assign( b, e );
+        d->begin = d->data.data();
+        d->end   = d->begin + d->data.size();
+      } else {
+        d->begin = b;
+        d->end   = e;
+      }
+      pool.submit( d );
+    }
+
+    void handle_document( document_pool::document *d ) {
+      if( d->doc ) {
+        for( std::vector<xmlNodePtr>::const_iterator i = d->matches.begin(); i != d->matches.end(); ++i )
+          dispatch_node( *i );
+        xmlFreeDoc( d->doc );
+      } else {
+        std::cerr << "Failed to parse " << std::endl;
+      }
+      delete d;
+
+      chunk_handled();
+    }
+
+    // Small chunks get the first matches out quickly on a slow pipe but they
+    // are expensive when the input is arriving faster than it is parsed.
+    // Grow the chunk whenever at least another whole chunk is already
+    // waiting to be read.
+    void adapt_chunk_size( std::streamsize num ) {
+      if( adaptive and num == bufsize and bufsize < max_adaptive_size and
+          bufsize <= in.rdbuf()->in_avail() ) {
+        resize_buf( std::min( 2 * bufsize, max_adaptive_size ) );
+        chunk_size_changed( bufsize );
+      }
+    }
+
+    /*
+     * Reads up to len characters from the stream like in.read() and returns
+     * how many were read.  When the stream is standard input nothing is read
+     * without calling wait_for_input() first unless it is already waiting.
+     * If partial is true this returns as soon as anything has been read
+     * instead of waiting for the rest.
+     */
+    std::streamsize read_input( Ch *b, std::streamsize len, bool partial ) {
+      if( -1 == input_fd() ) {
+        in.read( b, len );
+        return in.gcount();
+      }
+
+      std::streamsize total = 0;
+      while( total < len and in ) {
+        std::streamsize avail = in.rdbuf()->in_avail();
+        if( 0 == avail ) {
+          if( partial and total )
+            break;
+          wait_for_input();
+          avail = in.rdbuf()->in_avail();
+        }
+
+        std::streamsize want = len - total;
+        if( 0 < avail )
+          want = std::min( avail, want );
+        else if( partial )
+          want = 1;
+        in.read( b + total, want );
+        total += in.gcount();
+      }
+      return total;
+    }
+
+    // The descriptor behind the stream or -1 if it isn't known
+    int input_fd() const {
+      return &in == &std::cin ? 0 : -1;
+    }
+
+    static int reader_input( void *context, char *buffer, int len ) {
+      basic_xpath_stream *self = static_cast<basic_xpath_stream*>( context );
+      if( not self->in )
+        return 0;
+
+      std::streamsize num = self->read_input( buffer, std::min( len, self->bufsize ), true );
+      self->adapt_chunk_size( num );
+      return num;
+    }
+
+    // Feeds the reader from a mapping too big for xmlReaderForMemory()
+    static int reader_mapped_input( void *context, char *buffer, int len ) {
+      basic_xpath_stream *self = static_cast<basic_xpath_stream*>( context );
+      std::ptrdiff_t num = std::min<std::ptrdiff_t>( len, self->map_end - self->map_pos );
+      std::copy( self->map_pos, self->map_pos + num, buffer );
+      self->map_pos += num;
+      return num;
+    }
+
+    static int reader_close( void * ) { return 0; }
+
+    /*
+     * Advances the reader until at least one element has been handed to
+     * handle_node() or the document ends.
+     */
+    void read_elements() {
+      if( completed )
+        return;
+
+      if( not reader ) {
+        if( mapping.mapped() and mapping.size() <= INT_MAX )
+          reader = xmlReaderForMemory( mapping.begin(), mapping.size(), NULL, NULL, 0 );
+        else if( mapping.mapped() )
+          reader = xmlReaderForIO( reader_mapped_input, reader_close, this, NULL, NULL, 0 );
+        else
+          reader = xmlReaderForIO( reader_input, reader_close, this, NULL, NULL, 0 );
+        assert( reader );
+      }
+
+      bool dispatched = false;
+      while( not dispatched ) {
+        int ret = 1;
+        if( reader_next )
+          reader_next = false;
+        else
+          ret = xmlTextReaderRead( reader );
+
+        if( 1 != ret ) {
+          completed = true;
+          if( -1 == ret )
+            std::cerr << "Failed to parse " << std::endl;
+          xmlFreeTextReader( reader );
+          reader = NULL;
+          finish();
+          return;
+        }
+
+        switch( xmlTextReaderNodeType( reader ) ) {
+          case XML_READER_TYPE_ELEMENT : {
+            bool matched = matcher.push( xmlTextReaderConstLocalName( reader ),
+                                         xmlTextReaderConstNamespaceUri( reader ) );
+            if( matched ) {
+              xmlNodePtr node = xmlTextReaderExpand( reader );
+              if( not node ) {
+                matcher.pop();
+                break;
+              }
+              dispatch_expanded( node );
+              matcher.pop();
+              dispatch_node( node );
+              dispatched = true;
+
+              // Skip past the sub-tree.  The reader is left sitting on the
+              // next node so it must not be read again.
+              if( 1 == xmlTextReaderNext( reader ) )
+                reader_next = true;
+            } else if( xmlTextReaderIsEmptyElement( reader ) ) {
+              matcher.pop();
+            }
+            break;
+          }
+
+          case XML_READER_TYPE_END_ELEMENT :
+            matcher.pop();
+            break;
+        }
+      }
+    }
+
+    /*
+     * Runs the matcher over the descendants of an expanded element so that
+     * matches nested inside it are handled too, each one when it closes.
+     * The walk follows parent pointers so deep sub-trees can't overflow the
+     * stack.
+     */
+    void dispatch_expanded( xmlNodePtr top ) {
+      xmlNodePtr node = top->children;
+      while( node ) {
+        if( XML_ELEMENT_NODE == node->type ) {
+          open_matched.push_back( matcher.push( node->name, node->ns ? node->ns->href : NULL ) );
+          if( node->children ) {
+            node = node->children;
+            continue;
+          }
+          close_expanded( node );
+        }
+
+        // Move on to the next node closing each element on the way back up.
+        while( node != top and not node->next ) {
+          node = node->parent;
+          if( node != top )
+            close_expanded( node );
+        }
+        node = ( node == top ) ? NULL : node->next;
+      }
+    }
+
+    void close_expanded( xmlNodePtr node ) {
+      matcher.pop();
+      bool matched = open_matched.back();
+      open_matched.pop_back();
+      if( matched )
+        dispatch_node( node );
+    }
+
+    void resize_buf( int size ) {
+      delete [] buf;
+      bufsize = size;
+      buf = new Ch[ bufsize+1 ];
+      buf[bufsize] = '\0';
+    }
+
+    void dispatch_node( xmlNodePtr node ) {
+      if( not rootfound ) {
+        rootname = toChar( xmlDocGetRootElement( node->doc )->name );
+        begin_xml( rootname );
+        rootfound = true;
+      }
+      handle_node( node );
+    }
+
+    static void start_element( void *ctx,
+                               const xmlChar *localname,
+                               const xmlChar *prefix,
+                               const xmlChar *URI,
+                               int nb_namespaces,
+                               const xmlChar **namespaces,
+                               int nb_attributes,
+                               int nb_defaulted,
+                               const xmlChar **attributes ) {
+      xmlParserCtxtPtr    pctxt = static_cast<xmlParserCtxtPtr>( ctx );
+      basic_xpath_stream *self  = static_cast<basic_xpath_stream*>( pctxt->_private );
+
+      xmlSAX2StartElementNs( ctx, localname, prefix, URI,
+                             nb_namespaces, namespaces,
+                             nb_attributes, nb_defaulted, attributes );
+
+      bool matched = self->matcher.push( localname, URI );
+      self->open_matched.push_back( matched );
+      if( matched )
+        ++self->num_pending;
+    }
+
+    static void end_element( void *ctx,
+                             const xmlChar *localname,
+                             const xmlChar *prefix,
+                             const xmlChar *URI ) {
+      xmlParserCtxtPtr    pctxt = static_cast<xmlParserCtxtPtr>( ctx );
+      basic_xpath_stream *self  = static_cast<basic_xpath_stream*>( pctxt->_private );
+      xmlNodePtr          node  = pctxt->node;
+
+      xmlSAX2EndElementNs( ctx, localname, prefix, URI );
+
+      self->matcher.pop();
+      if( self->open_matched.empty() )
+        return;
+      bool matched = self->open_matched.back();
+      self->open_matched.pop_back();
+
+      if( not node )
+        return;
+
+      if( matched ) {
+        --self->num_pending;
+        self->dispatch_node( node );
+      }
+
+      // Nothing above this element needs it anymore so free it along with any
+      // text or comments that came before it.  The root element stays.
+      if( 0 == self->num_pending and node->parent and
+          XML_ELEMENT_NODE == node->parent->type ) {
+        while( node->prev and XML_ELEMENT_NODE != node->prev->type ) {
+          xmlNodePtr prev = node->prev;
+          xmlUnlinkNode( prev );
+          xmlFreeNode(   prev );
+        }
+        xmlUnlinkNode( node );
+        xmlFreeNode(   node );
+      }
+    }
+
     bool nodeIsComplete( xmlNodePtr node ) {
       if( not node )         return false;
       if( completed )        return true;
@@ -162,47 +691,85 @@ class basic_xpath_stream {
       return nodeIsComplete( node->parent );
     }
 
+    /*
+     * The match state of each node found by the fallback evaluation is kept
+     * in the node's _private pointer rather than in a separate container.
+     * The markers only need distinct addresses.  A node that is freed takes
+     * its state with it.
+     */
+    static char *processed_mark()   { static char mark; return &mark; }
+    static char *unprocessed_mark() { static char mark; return &mark; }
+
+    static void mark_node( xmlNodePtr node, char *(*mark)() ) {
+      node->_private = mark();
+    }
+
+    static bool is_processed( xmlNodePtr node ) {
+      return processed_mark() == node->_private;
+    }
+
+    static bool is_unprocessed( xmlNodePtr node ) {
+      return unprocessed_mark() == node->_private;
+    }
+
     // Returns true if the parent may unlink this node
     bool trim_nodes( xmlNodePtr node, const bool right = true ) {
       if( not node ) return false;
 
-      if( unprocessed.count( node ) ) return false;
+      if( is_unprocessed( node ) ) return false;
 
       bool trimall = true;
-      std::stack<xmlNodePtr> trim;
 
-      // First recurse into children to see which can be trimmed.
-      for( xmlNodePtr child = node->children; child; child = child->next )
-        if( trim_nodes( child, child == node->last ? right : false ) )
-          trim.push( child );
-        else
+      // First recurse into children to see which can be trimmed.  If they
+      // all can then the parent frees this whole sub-tree anyway so it is
+      // fine to free them now.
+      xmlNodePtr next;
+      for( xmlNodePtr child = node->children; child; child = next ) {
+        next = child->next;
+        if( trim_nodes( child, child == node->last ? right : false ) ) {
+          xmlUnlinkNode( child );
+          xmlFreeNode(   child );
+        } else {
           trimall = false;
-
-      if( trimall and not right ) {
-        // This whole sub-tree can be trimmed.  Leave this up to the parent.
-        processed.erase( node );
-        return true;
-      } else {
-        // Trim the children
-        while( not trim.empty() ) {
-          xmlUnlinkNode(   trim.top() );
-          xmlFreeNode(     trim.top() );
-          trim.pop();
         }
-
-        return false;
       }
+
+      // This whole sub-tree can be trimmed.  Leave this up to the parent.
+      return trimall and not right;
     }
 
     std::istream &in;
     int bufsize;
     Ch *buf;
+    bool adaptive;
+
+    static const int max_adaptive_size = 64 * 1024;
 
     bool                 initialized,printroot,rootfound,completed,fileatonce;
     xmlParserCtxtPtr     ctxt;
     const char          *xpathExpr;
-    std::set<xmlNodePtr> processed;
-    std::set<xmlNodePtr> unprocessed;
+    xmlXPathCompExprPtr  xpathComp;
+    xmlXPathContextPtr   xpathCtx;
+
+    // Streaming matcher state
+    bool                 streaming;
+    stream_matcher       matcher;
+    std::vector<bool>    open_matched;
+    int                  num_pending;
+
+    // Bounded memory reader state
+    xmlTextReaderPtr     reader;
+    bool                 use_reader, reader_next;
+
+    // Memory mapped input
+    mapped_file          mapping;
+    const Ch            *map_pos, *map_end;
+
+    // Multiple documents
+    bool                 multi_document;
+    document_splitter    splitter;
+    int                  parse_threads;
+    bool                 document_order;
 
     static const int header_size = 5;
     Ch header[ header_size ];
@@ -213,4 +780,8 @@ class basic_xpath_stream {
     basic_xpath_stream( const basic_xpath_stream& );
 };
 
+// std::min takes its arguments by reference so this needs a definition.
+template<class Ch, class Tr>
+const int basic_xpath_stream<Ch, Tr>::max_adaptive_size;
+
 #endif